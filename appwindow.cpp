@@ -82,12 +82,34 @@ AppWindow::AppWindow(QWidget *parent) :
             hideBufferContents();
             ui->post_kernel_size->setEnabled(true);
             scene().useSimpleBlur();
-        } else if(value == "2-Pass 9x9 Gauss") {
+        } else if(value == "2-Pass Gauss") {
             scene().useTwoPassGauss();
             hideBufferContents();
-            ui->post_kernel_size->setDisabled(true);
+            ui->post_kernel_size->setEnabled(true);
+        } else if(value == "Dual Filter Blur") {
+            scene().useDualFilterBlur();
+            hideBufferContents();
+            ui->post_kernel_size->setEnabled(true);
+        } else if(value == "Accumulated Motion Blur") {
+            scene().useAccumulatedMotionBlur();
+            hideBufferContents();
+        } else if(value == "Velocity Motion Blur") {
+            scene().useVelocityMotionBlur();
+            hideBufferContents();
+        } else if(value == "Blur, Gauss, Motion Blur") {
+            scene().setPostEffects({ "blur", "gauss", "motion_blur" });
+            hideBufferContents();
+            ui->post_kernel_size->setEnabled(true);
+        } else if(value == "Sharpen, Tone Curve, Vignette") {
+            scene().setPostEffects({ "sharpen", "tone_curve", "vignette" });
+            hideBufferContents();
+        } else if(value == "Tone Curve, Grayscale, Vignette") {
+            scene().setPostEffects({ "tone_curve", "grayscale", "vignette" });
+            hideBufferContents();
         }
     } );
+    connect(ui->fuseEffectsCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().togglePostFusion(value); } );
     connect(ui->splitScreenCheckbox, &QCheckBox::toggled,
             [this](bool value) { scene().toggleSplitDisplay(value); } );
     connect(ui->showFBOtoggle, &QCheckBox::toggled,
@@ -99,9 +121,27 @@ AppWindow::AppWindow(QWidget *parent) :
     connect(ui->jitterCheckbox, &QCheckBox::toggled,[this](bool value){ scene().toggleJittering(value); });
     connect(ui->playerVis, &QCheckBox::toggled,[this](bool value){ scene().togglePlayerVisibility(value); });
 
+    // rendering pipeline options -----------------------------
+    connect(ui->occlusionCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().toggleOcclusionQueries(value); } );
+    connect(ui->singlePassCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().toggleSinglePassLighting(value); } );
+    connect(ui->deferredCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().toggleDeferredShading(value); } );
+    connect(ui->clusteredCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().toggleClusteredLighting(value); } );
+    connect(ui->prePassCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().toggleDepthPrePass(value); } );
+    connect(ui->shadowsCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().toggleShadows(value); } );
+    connect(ui->statsCheckbox, &QCheckBox::toggled,
+            [this](bool value) { scene().toggleStatsOutput(value); } );
+
     // strange cast here: see https://stackoverflow.com/questions/16794695/connecting-overloaded-signals-and-slots-in-qt-5
     connect(ui->post_kernel_size, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
             [this](int value) { scene().setPostFilterKernelSize(value); } );
+    connect(ui->motionBlurFrames, static_cast<void (QSpinBox::*)(int)>(&QSpinBox::valueChanged),
+            [this](int value) { scene().setMotionBlurFrames(value); } );
 
 }
 
@@ -1,4 +1,5 @@
 #include "camera.h"
+#include "render/glstate.h"
 #include <assert.h>
 
 using namespace std;
@@ -9,6 +10,13 @@ Camera::Camera(QMatrix4x4 view,
 {
     // set uniform names to their default values (IMPORTANT!)
     setMatrixUniformNames();
+    position_WC_ = viewMatrix_.inverted() * QVector3D(0,0,0);
+}
+
+void Camera::setViewMatrix(QMatrix4x4 mat)
+{
+    viewMatrix_ = mat;
+    position_WC_ = viewMatrix_.inverted() * QVector3D(0,0,0);
 }
 
 void Camera::setShaderTransformationMatrices(Material &material,
@@ -20,14 +28,13 @@ void Camera::setShaderTransformationMatrices(Material &material,
     QMatrix4x4 mv  = viewMatrix_ * modelMatrix;
     QMatrix4x4 mvp = projectionMatrix_ * mv;
 
-    prog.bind();
-    prog.setUniformValue(name_m_.c_str(),   modelMatrix);
-    prog.setUniformValue(name_v_.c_str(),   viewMatrix_);
-    prog.setUniformValue(name_iv_.c_str(),  viewMatrix_.inverted());
-    prog.setUniformValue(name_p_.c_str(),   projectionMatrix_);
-    prog.setUniformValue(name_mv_.c_str(),  mv);
-    prog.setUniformValue(name_n_.c_str(),   mv.normalMatrix());
-    prog.setUniformValue(name_mvp_.c_str(), mvp);
+    auto& uniforms = material.uniforms();
+
+    GLState::current().useProgram(prog);
+    uniforms.set(name_m_.c_str(),   modelMatrix);
+    uniforms.set(name_mv_.c_str(),  mv);
+    uniforms.set(name_n_.c_str(),   mv.normalMatrix());
+    uniforms.set(name_mvp_.c_str(), mvp);
 
 #if 0
     qDebug() << "modelview: ";
@@ -41,17 +48,11 @@ void Camera::setShaderTransformationMatrices(Material &material,
 }
 
 void Camera::setMatrixUniformNames(const string m,
-                                   const string v,
-                                   const string iv,
-                                   const string p,
                                    const string mv,
                                    const string n,
                                    const string mvp)
 {
     name_m_   = m;
-    name_v_   = v;
-    name_iv_  = iv;
-    name_p_   = p;
     name_mv_  = mv;
     name_n_   = n;
     name_mvp_ = mvp;
@@ -23,12 +23,20 @@ public:
     virtual QMatrix4x4 viewMatrix() const { return viewMatrix_; }
     virtual QMatrix4x4 projectionMatrix() const { return projectionMatrix_; }
 
-    virtual void setViewMatrix(QMatrix4x4 mat) { viewMatrix_ = mat; }
+    virtual void setViewMatrix(QMatrix4x4 mat);
+
+    // eye position in world coordinates, computed when the view matrix is set
+    QVector3D position_WC() const { return position_WC_; }
     virtual void setProjectionMatrix(QMatrix4x4 mat) { projectionMatrix_ = mat; }
 
     /*
-     *  Set OpenGL shader uniform variables for M / V / P matrices etc.
-     *  Always apply before using the actual material for rendering!
+     *  Set OpenGL shader uniform variables for the model-dependent
+     *  matrices (M, MV, N, MVP). Always apply before using the actual
+     *  material for rendering!
+     *
+     *  View and projection matrices are the same for all draws of a
+     *  frame; they are set once per frame in the FrameData uniform
+     *  block, see FrameUniforms.
      *
      *  Uniforms to be set: see setMatrixUniformNames()
      *
@@ -41,9 +49,6 @@ public:
      *  in future calls of setMatrices() for this camera object.
      */
     void setMatrixUniformNames(const std::string m    = "modelMatrix",
-                               const std::string v    = "viewMatrix",
-                               const std::string iv   = "inverseViewMatrix",
-                               const std::string p    = "projectionMatrix",
                                const std::string mv   = "modelViewMatrix",
                                const std::string n    = "normalMatrix",
                                const std::string mvp  = "modelViewProjectionMatrix");
@@ -51,9 +56,10 @@ public:
 protected:
 
     QMatrix4x4 viewMatrix_, projectionMatrix_;
+    QVector3D position_WC_;
 
     // uniform names for the calculated matrices
-    std::string name_m_, name_v_, name_iv_, name_p_, name_mv_, name_n_, name_mvp_;
+    std::string name_m_, name_mv_, name_n_, name_mvp_;
 
 };
 
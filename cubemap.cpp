@@ -1,6 +1,7 @@
 #include <assert.h>
 
 #include "cubemap.h"
+#include "jobs/jobsystem.h"
 #include <qdebug.h>
 #include <QFile>
 
@@ -16,17 +17,19 @@ std::shared_ptr<QOpenGLTexture>
 makeCubeMap(string path_to_images, std::array<string, 6> sides)
 {
 
-    // load six images for the six sides of the cube
-    std::vector<QImage> images;
-    for(auto side : sides) {
-        QString filename = (path_to_images + "/" + side).c_str();
-        QImage img(filename);
-        assert(!img.isNull());
-        // not we do not use .mirrored() in the following line, since
-        // cube maps have opposite Y orientation thanks to RenderMan,
-        // see https://stackoverflow.com/questions/12824647/cube-map-not-working-opengl
-        images.push_back( img.convertToFormat(QImage::Format_RGBA8888) );
-    }
+    // load six images for the six sides of the cube, decoded in parallel
+    std::vector<QImage> images(sides.size());
+    JobSystem::instance().parallelFor(0, sides.size(), 1, [&](size_t from, size_t to) {
+        for(size_t i=from; i<to; i++) {
+            QString filename = (path_to_images + "/" + sides[i]).c_str();
+            QImage img(filename);
+            assert(!img.isNull());
+            // not we do not use .mirrored() in the following line, since
+            // cube maps have opposite Y orientation thanks to RenderMan,
+            // see https://stackoverflow.com/questions/12824647/cube-map-not-working-opengl
+            images[i] = img.convertToFormat(QImage::Format_RGBA8888);
+        }
+    });
 
     // create and allocate cube map texture
     std::shared_ptr<QOpenGLTexture> tex_;
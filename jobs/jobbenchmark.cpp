@@ -0,0 +1,110 @@
+#include "jobs/jobbenchmark.h"
+#include "jobs/jobsystem.h"
+
+#include <iostream> // std::cout
+#include <iomanip>  // std::setw
+#include <chrono>   // clock, time calculations
+#include <cmath>    // std::sin
+#include <atomic>   // std::atomic
+#include <algorithm> // std::max
+#include <thread>   // std::thread::hardware_concurrency
+
+using namespace std;
+
+namespace {
+
+using Clock = chrono::high_resolution_clock;
+
+double microsecondsSince(Clock::time_point start)
+{
+    return chrono::duration<double, micro>(Clock::now() - start).count();
+}
+
+// some floating point work that the compiler cannot optimize away
+float work(size_t i)
+{
+    float x = float(i);
+    for(int k=0; k<200; k++)
+        x = sin(x) + 1.0f;
+    return x;
+}
+
+// submit n independent empty tasks, then wait for all of them
+double emptyTasks(JobSystem& jobs, size_t n)
+{
+    auto start = Clock::now();
+    vector<JobSystem::TaskHandle> tasks;
+    tasks.reserve(n);
+    for(size_t i=0; i<n; i++)
+        tasks.push_back(jobs.submit([]{}));
+    jobs.wait(tasks);
+    return microsecondsSince(start) / n;
+}
+
+// chain of n empty tasks, each depending on its predecessor
+double dependencyChain(JobSystem& jobs, size_t n)
+{
+    auto start = Clock::now();
+    JobSystem::TaskHandle last;
+    for(size_t i=0; i<n; i++)
+        last = jobs.submit([]{}, {last});
+    jobs.wait(last);
+    return microsecondsSince(start) / n;
+}
+
+// fixed amount of work, distributed with parallelFor
+double parallelWork(JobSystem& jobs, size_t n, size_t grain)
+{
+    vector<float> result(n);
+    auto start = Clock::now();
+    jobs.parallelFor(0, n, grain, [&result](size_t from, size_t to) {
+        for(size_t i=from; i<to; i++)
+            result[i] = work(i);
+    });
+    return microsecondsSince(start) / 1000.0;
+}
+
+// the same work on the calling thread alone, the baseline for speedups
+double serialWork(size_t n)
+{
+    vector<float> result(n);
+    auto start = Clock::now();
+    for(size_t i=0; i<n; i++)
+        result[i] = work(i);
+    return microsecondsSince(start) / 1000.0;
+}
+
+} // namespace
+
+void runJobSystemBenchmark()
+{
+    const size_t maxThreads = max(1u, thread::hardware_concurrency());
+
+    cout << "JobSystem benchmark, " << maxThreads << " hardware threads" << endl;
+
+    // scheduling overhead, using the default number of workers
+    {
+        JobSystem jobs;
+        emptyTasks(jobs, 1000); // warm up
+        cout << "  workers:                 " << jobs.numWorkers() << endl;
+        cout << "  empty task:              " << emptyTasks(jobs, 100000) << " us/task" << endl;
+        cout << "  dependency chain:        " << dependencyChain(jobs, 100000) << " us/task" << endl;
+        cout << "  parallelFor, 1 elem/chunk: "
+             << parallelWork(jobs, 10000, 1) * 1000.0 / 10000 << " us/elem" << endl;
+    }
+
+    // scaling across core counts. parallelFor runs chunks on the calling
+    // thread too, so t threads means t-1 workers; t=1 is plain serial code.
+    const size_t n = 200000, grain = 256;
+    serialWork(n / 10); // warm up
+    double single = serialWork(n);
+    cout << "  scaling (" << n << " elements, grain " << grain << "):" << endl;
+    cout << "    " << setw(3) << 1 << " threads: " << setw(9) << single << " ms, serial" << endl;
+    for(size_t t=2; t<=maxThreads; t++) {
+        JobSystem jobs(t - 1);
+        parallelWork(jobs, n / 10, grain); // warm up
+        double ms = parallelWork(jobs, n, grain);
+        cout << "    " << setw(3) << t << " threads: " << setw(9) << ms << " ms, speedup "
+             << single / ms << endl;
+    }
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+/*
+ *  Micro benchmarks for the JobSystem, printed to stdout:
+ *  - scheduling overhead: cost of submitting and finishing empty tasks,
+ *    with and without dependency chains
+ *  - scaling: a fixed compute-bound parallelFor workload,
+ *    run with 1 ... N worker threads
+ *
+ *  Run the app with command line option --benchmark-jobs.
+ *
+ */
+void runJobSystemBenchmark();
+
@@ -0,0 +1,218 @@
+#include "jobs/jobsystem.h"
+
+#include <algorithm> // std::max, std::min
+#include <chrono>    // std::chrono::microseconds
+
+using namespace std;
+
+namespace {
+
+// scheduler and worker index of the current thread (-1: not a worker)
+thread_local JobSystem* tl_system = nullptr;
+thread_local int tl_index = -1;
+
+}
+
+JobSystem::JobSystem(size_t numWorkers)
+{
+    // the thread using the scheduler helps while waiting, so leave one core for it
+    if(numWorkers == 0) {
+        unsigned int cores = thread::hardware_concurrency();
+        numWorkers = cores > 1? cores - 1 : 1;
+    }
+
+    // create all deques before any thread starts stealing from them
+    for(size_t i=0; i<numWorkers; i++)
+        workers_.push_back(make_unique<Worker>());
+    for(size_t i=0; i<numWorkers; i++)
+        workers_[i]->thread = thread(&JobSystem::workerLoop, this, int(i));
+}
+
+JobSystem::~JobSystem()
+{
+    {
+        lock_guard<mutex> lock(sleepMutex_);
+        running_ = false;
+    }
+    wakeUp_.notify_all();
+
+    for(auto& w : workers_)
+        w->thread.join();
+}
+
+JobSystem& JobSystem::instance()
+{
+    static JobSystem system;
+    return system;
+}
+
+JobSystem::TaskHandle JobSystem::submit(function<void()> job,
+                                        const vector<TaskHandle>& dependencies)
+{
+    auto task = make_shared<Task>();
+    task->job_ = move(job);
+
+    // one extra count, so the task cannot start while dependencies are being registered
+    task->unfinished_ = int(dependencies.size()) + 1;
+    for(const auto& dep : dependencies) {
+        if(!dep) {
+            task->unfinished_--;
+            continue;
+        }
+        lock_guard<mutex> lock(dep->mutex_);
+        if(dep->isDone())
+            task->unfinished_--;
+        else
+            dep->dependents_.push_back(task);
+    }
+
+    if(--task->unfinished_ == 0)
+        enqueue(task);
+
+    return task;
+}
+
+void JobSystem::enqueue(TaskHandle task)
+{
+    // workers push into their own deque, everybody else round-robin
+    size_t index = (tl_system == this && tl_index >= 0)?
+                size_t(tl_index) : nextWorker_++ % workers_.size();
+
+    {
+        auto& w = *workers_[index];
+        lock_guard<mutex> lock(w.mutex);
+        queued_++;
+        w.tasks.push_back(move(task));
+    }
+
+    // taking the lock makes sure a worker about to sleep sees the new task
+    { lock_guard<mutex> lock(sleepMutex_); }
+    wakeUp_.notify_one();
+}
+
+JobSystem::TaskHandle JobSystem::findTask(int self)
+{
+    // own deque first, newest task
+    if(self >= 0) {
+        auto& w = *workers_[self];
+        lock_guard<mutex> lock(w.mutex);
+        if(!w.tasks.empty()) {
+            TaskHandle task = move(w.tasks.back());
+            w.tasks.pop_back();
+            queued_--;
+            return task;
+        }
+    }
+
+    // steal the oldest task of another worker
+    size_t n = workers_.size();
+    size_t start = self >= 0? size_t(self) + 1 : nextWorker_.load();
+    for(size_t i=0; i<n; i++) {
+        auto& w = *workers_[(start + i) % n];
+        if(int((start + i) % n) == self)
+            continue;
+        lock_guard<mutex> lock(w.mutex);
+        if(!w.tasks.empty()) {
+            TaskHandle task = move(w.tasks.front());
+            w.tasks.pop_front();
+            queued_--;
+            return task;
+        }
+    }
+
+    return nullptr;
+}
+
+void JobSystem::execute(const TaskHandle& task)
+{
+    task->job_();
+    task->job_ = nullptr; // release whatever the job captured
+
+    vector<TaskHandle> dependents;
+    {
+        lock_guard<mutex> lock(task->mutex_);
+        task->done_.store(true, memory_order_release);
+        dependents.swap(task->dependents_);
+    }
+
+    for(auto& d : dependents) {
+        if(--d->unfinished_ == 0)
+            enqueue(move(d));
+    }
+}
+
+void JobSystem::workerLoop(int index)
+{
+    tl_system = this;
+    tl_index = index;
+
+    for(;;) {
+        if(TaskHandle task = findTask(index)) {
+            execute(task);
+            continue;
+        }
+
+        unique_lock<mutex> lock(sleepMutex_);
+        wakeUp_.wait(lock, [this] { return !running_ || queued_.load() > 0; });
+        if(!running_ && queued_.load() == 0)
+            return;
+    }
+}
+
+void JobSystem::wait(const TaskHandle &task)
+{
+    if(!task)
+        return;
+
+    int self = (tl_system == this)? tl_index : -1;
+    int idle = 0;
+
+    while(!task->isDone()) {
+
+        // help instead of blocking
+        if(TaskHandle other = findTask(self)) {
+            execute(other);
+            idle = 0;
+            continue;
+        }
+
+        // nothing to do: the task is running on another thread.
+        // spin briefly, then sleep in short intervals.
+        if(++idle < 64) {
+            this_thread::yield();
+        } else {
+            unique_lock<mutex> lock(sleepMutex_);
+            wakeUp_.wait_for(lock, chrono::microseconds(100),
+                             [&] { return task->isDone() || queued_.load() > 0; });
+        }
+    }
+}
+
+void JobSystem::wait(const vector<TaskHandle> &tasks)
+{
+    for(const auto& t : tasks)
+        wait(t);
+}
+
+void JobSystem::parallelFor(size_t begin, size_t end, size_t grain,
+                            const function<void (size_t, size_t)> &body)
+{
+    if(end <= begin)
+        return;
+
+    grain = max(grain, size_t(1));
+    size_t chunks = (end - begin + grain - 1) / grain;
+
+    // all but the first chunk go to the workers
+    vector<TaskHandle> tasks;
+    tasks.reserve(chunks);
+    for(size_t c=1; c<chunks; c++) {
+        size_t from = begin + c * grain;
+        size_t to = min(end, from + grain);
+        tasks.push_back(submit([&body, from, to] { body(from, to); }));
+    }
+
+    // the calling thread does the first chunk, then helps with the rest
+    body(begin, min(end, begin + grain));
+    wait(tasks);
+}
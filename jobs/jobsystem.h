@@ -0,0 +1,130 @@
+#pragma once
+
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <deque>              // std::deque
+#include <functional>         // std::function
+#include <memory>             // std::shared_ptr, std::unique_ptr
+#include <mutex>              // std::mutex
+#include <thread>             // std::thread
+#include <vector>             // std::vector
+
+/*
+ *  Work-stealing task scheduler with a fixed set of worker threads.
+ *
+ *  Each worker owns a deque of tasks. A worker pushes and pops tasks
+ *  at the back of its own deque (most recent first, cache friendly),
+ *  and when it runs dry it steals from the front of other workers'
+ *  deques (oldest first, usually the biggest chunks of work).
+ *  Tasks submitted from outside the pool (e.g. the GUI/GL thread) are
+ *  dealt out round-robin.
+ *
+ *  Tasks can depend on other tasks; a task is only queued once all of
+ *  its dependencies have finished. Threads waiting for a task help
+ *  executing queued tasks instead of blocking, so waiting from within
+ *  a task (nested parallelism) does not dead-lock.
+ *
+ *  The scheduler is used by the mesh loader and texture decoding
+ *  (see Scene::makeNodes()), cube map loading and draw list building
+ *  (culling). It does not use Qt and must not issue OpenGL calls,
+ *  since the workers have no OpenGL context.
+ *
+ *  Usage:
+ *      auto& jobs = JobSystem::instance();
+ *      auto a = jobs.submit([]{ ... });
+ *      auto b = jobs.submit([]{ ... }, {a});  // runs after a
+ *      jobs.parallelFor(0, n, 64, [&](size_t from, size_t to) { ... });
+ *      jobs.wait(b);
+ *
+ */
+class JobSystem
+{
+public:
+
+    class Task;
+    using TaskHandle = std::shared_ptr<Task>;
+
+    // number of workers; 0 = one per hardware thread, minus the calling thread
+    explicit JobSystem(size_t numWorkers = 0);
+    ~JobSystem();
+
+    // app-wide scheduler, created on first use
+    static JobSystem& instance();
+
+    // number of worker threads (not counting threads that help while waiting)
+    size_t numWorkers() const { return workers_.size(); }
+
+    // queue a task; it will run once all dependencies have finished
+    TaskHandle submit(std::function<void()> job,
+                      const std::vector<TaskHandle>& dependencies = {});
+
+    // wait until the task has finished, executing other tasks meanwhile
+    void wait(const TaskHandle& task);
+
+    // wait for several tasks
+    void wait(const std::vector<TaskHandle>& tasks);
+
+    /*
+     *  Split [begin, end) into chunks of at most grain elements,
+     *  run body(chunk_begin, chunk_end) for each chunk in parallel,
+     *  and return when all chunks are done. The calling thread takes
+     *  part in the work.
+     */
+    void parallelFor(size_t begin, size_t end, size_t grain,
+                     const std::function<void(size_t, size_t)>& body);
+
+    // do not copy the scheduler, it owns threads
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    /*
+     *  A unit of work. Only accessed through TaskHandle.
+     */
+    class Task {
+    public:
+        bool isDone() const { return done_.load(std::memory_order_acquire); }
+    private:
+        friend class JobSystem;
+        std::function<void()> job_;
+        std::atomic<bool> done_{false};
+        std::atomic<int> unfinished_{0};           // dependencies + 1 while submitting
+        std::mutex mutex_;                         // protects dependents_ and done_ transition
+        std::vector<TaskHandle> dependents_;       // tasks waiting for this one
+    };
+
+protected:
+
+    // one deque per worker, owner works at the back, thieves at the front
+    struct Worker {
+        std::thread thread;
+        std::mutex mutex;
+        std::deque<TaskHandle> tasks;
+    };
+
+    // put a task whose dependencies are all done into a deque
+    void enqueue(TaskHandle task);
+
+    // get a task from the own deque, or steal one; nullptr if there is none
+    TaskHandle findTask(int self);
+
+    // run a task and release the tasks depending on it
+    void execute(const TaskHandle& task);
+
+    // main loop of worker thread number index
+    void workerLoop(int index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // number of queued (not yet started) tasks, used for sleeping
+    std::atomic<size_t> queued_{0};
+
+    // round-robin target for tasks submitted by non-worker threads
+    std::atomic<size_t> nextWorker_{0};
+
+    // idle workers (and waiting threads) sleep here
+    std::mutex sleepMutex_;
+    std::condition_variable wakeUp_;
+    bool running_ = true;
+
+};
+
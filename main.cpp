@@ -5,21 +5,28 @@
 #include <QSurfaceFormat>
 
 #include "appwindow.h"
+#include "jobs/jobbenchmark.h"
 
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
 
+    // command line option: only run the job system benchmark
+    if(app.arguments().contains("--benchmark-jobs")) {
+        runJobSystemBenchmark();
+        return 0;
+    }
+
     // these values will determine under which key settings are stored
     QCoreApplication::setOrganizationName("Beuth Hochschule");
     QCoreApplication::setOrganizationDomain("beuth-hochschule.de");
     QCoreApplication::setApplicationName("RTR demo");
 
-    // format to require OpenGL 3.2 and the right kinds of buffers
+    // format to require OpenGL 3.3 (sampler objects) and the right kinds of buffers
     QSurfaceFormat format;
     format.setMajorVersion(3);
-    format.setMinorVersion(2);
+    format.setMinorVersion(3);
     format.setProfile(QSurfaceFormat::CoreProfile);
     format.setOption(QSurfaceFormat::DebugContext); // enable OpenGL debugging!!!
 
@@ -0,0 +1,20 @@
+#include "material/deferredlight.h"
+#include "render/glstate.h"
+#include "render/textureunits.h"
+
+#include <assert.h>
+
+void DeferredLightMaterial::apply(unsigned int light_pass)
+{
+    assert(gbuffer);
+    GLState::current().useProgram(*prog_);
+
+    // G-buffer texels are fetched 1:1, no filtering
+    auto& units = TextureUnits::current();
+    const auto screen = TextureUnits::Sampler::Screen;
+    uniforms_->set("gAlbedo", units.bind(GL_TEXTURE_2D, gbuffer->texture(GBuffer::Albedo), screen));
+    uniforms_->set("gNormalDepth", units.bind(GL_TEXTURE_2D, gbuffer->texture(GBuffer::NormalDepth), screen));
+    uniforms_->set("gEmission", units.bind(GL_TEXTURE_2D, gbuffer->texture(GBuffer::Emission), screen));
+
+    uniforms_->set("lightPass", int(light_pass));
+}
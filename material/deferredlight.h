@@ -0,0 +1,24 @@
+#pragma once
+
+#include "material/material.h"
+#include "render/gbuffer.h"
+
+/*
+ *  Light pass of the deferred pipeline: shades the pixels of a
+ *  full-viewport rectangle from the G-buffer, one light per pass.
+ *  Pass 0 also writes the emission (ambient, emissive, environment).
+ *
+ */
+class DeferredLightMaterial : public Material {
+public:
+
+    // constructor requires existing shader program
+    DeferredLightMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : Material(prog) {}
+
+    // G-buffer to be lit, needs to be set from outside
+    GBuffer* gbuffer = nullptr;
+
+    // bind underlying shader program, G-buffer textures and the light index
+    void apply(unsigned int light_pass = 0) override;
+
+};
@@ -0,0 +1,7 @@
+#include "material/depthonly.h"
+#include "render/glstate.h"
+
+void DepthOnlyMaterial::apply(unsigned int)
+{
+    GLState::current().useProgram(*prog_);
+}
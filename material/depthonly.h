@@ -0,0 +1,21 @@
+#pragma once
+
+#include "material/material.h"
+
+/*
+ *  Trivial material that only transforms vertices and does not
+ *  produce any color. Used for drawing proxy geometry, e.g. the
+ *  bounding boxes of occlusion queries.
+ *
+ */
+class DepthOnlyMaterial : public Material {
+public:
+
+    // constructor requires existing shader program
+    DepthOnlyMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : Material(prog) {}
+
+    // bind underlying shader program, there are no uniforms besides the matrices
+    void apply(unsigned int light_pass = 0) override;
+
+};
+
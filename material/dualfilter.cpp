@@ -0,0 +1,19 @@
+#include "material/dualfilter.h"
+
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::log2, std::lround
+
+using namespace std;
+
+int DualFilterMaterial::levels() const
+{
+    // each level doubles the radius
+    int n = max(kernel_size.width(), 1);
+    return min(max(int(lround(log2(float(n)))), 1), 8);
+}
+
+void DualFilterMaterial::apply(unsigned int light_pass)
+{
+    PostMaterial::apply(light_pass);
+    uniforms_->set("offset", offset);
+}
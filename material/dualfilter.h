@@ -0,0 +1,28 @@
+#pragma once
+
+#include "material/postmaterial.h"
+
+/*
+ *  One step of the dual filter (dual Kawase) blur: downsampling to half
+ *  the size, or upsampling to twice the size, with a few bilinear taps
+ *  around the pixel. A chain of steps down and back up blurs with a
+ *  radius that doubles per level, at almost constant cost.
+ *
+ */
+class DualFilterMaterial : public PostMaterial {
+public:
+
+    // constructor requires existing shader program
+    DualFilterMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : PostMaterial(prog)
+    { textureSampler_ = TextureUnits::Sampler::ScreenLinear; }
+
+    // distance of the taps, in texels of the input image
+    float offset = 1.0f;
+
+    // number of levels down (and up) for the kernel size (kernel_size)
+    int levels() const;
+
+    // bind program and texture (filtered), set the tap distance
+    void apply(unsigned int light_pass = 0) override;
+
+};
@@ -4,5 +4,7 @@
 
 /* Material is purely an interface class, no implementation needed */
 
+const unsigned int Material::allLights;
+
 
 
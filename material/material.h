@@ -2,6 +2,8 @@
 
 #include <QOpenGLShaderProgram>
 
+#include "render/uniformcache.h"
+
 #include <memory>
 
 /*
@@ -17,7 +19,7 @@ public:
      *
      */
     Material(std::shared_ptr<QOpenGLShaderProgram> prog)
-        :prog_(prog)
+        :prog_(prog), uniforms_(&UniformCache::of(*prog))
     {}
 
     /*
@@ -25,21 +27,56 @@ public:
      *  This method needs to be overwritten by the derived class.
      *
      *  light_pass is an optional argument so the shader may be called
-     *  once for each light (or type of light).
+     *  once for each light (or type of light), or allLights to shade
+     *  all lights in a single pass.
      *
      */
     virtual void apply(unsigned int light_pass = 0) = 0;
 
+    // light_pass value for single-pass lighting
+    static const unsigned int allLights = ~0u;
+
+    /*
+     *  selectProgram: materials with several program variants switch
+     *  to the one matching their current settings. Called once per
+     *  frame on the GL thread, before the frame's draw list is built.
+     *
+     */
+    virtual void selectProgram() {}
+
+    // does the vertex shader move vertices (e.g. displacement mapping)?
+    // Depth-only passes must then draw with this material, see DrawList::submitDepth()
+    virtual bool displacesVertices() const { return false; }
+
     /*
      * returns the underlying OpenGL shader program object
      *
      */
     QOpenGLShaderProgram& program() const { return *prog_; }
 
+    /*
+     * uniform cache of the program, use it to set all uniforms
+     *
+     */
+    UniformCache& uniforms() const { return *uniforms_; }
+
+    /*
+     * switch to another program, e.g. from a fallback to the real
+     * program once it is compiled (see ProgramCompiler)
+     *
+     */
+    void setProgram(std::shared_ptr<QOpenGLShaderProgram> prog) {
+        prog_ = prog;
+        uniforms_ = &UniformCache::of(*prog_);
+    }
+
 protected:
 
     // reference to underlying shader program
     std::shared_ptr<QOpenGLShaderProgram> prog_;
+
+    // locations and last values of the program's uniforms
+    UniformCache* uniforms_;
 };
 
 
@@ -0,0 +1,7 @@
+#include "material/motionblur.h"
+
+void MotionBlurMaterial::apply(unsigned int light_pass)
+{
+    PostMaterial::apply(light_pass);
+    uniforms_->set("frames", GLint(frames));
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "material/postmaterial.h"
+
+/*
+ *  Post processing material of the motion blur variants that work on
+ *  a number of frames: resolving the accumulated sum of the last frames,
+ *  or sampling along the velocity of each pixel.
+ *
+ */
+class MotionBlurMaterial : public PostMaterial {
+public:
+
+    // constructor requires existing shader program
+    MotionBlurMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : PostMaterial(prog) {}
+
+    // frames accumulated, or length of the velocity trail in frames
+    int frames = 8;
+
+    // bind program and textures, set the number of frames
+    void apply(unsigned int light_pass = 0) override;
+
+};
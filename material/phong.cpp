@@ -1,26 +1,30 @@
 #include "material/phong.h"
+#include "render/frameuniforms.h"
+#include "render/glstate.h"
 #include <assert.h>
 
 void PhongMaterial::apply(unsigned int light_pass)
 {
-    prog_->bind();
+    GLState::current().useProgram(*prog_);
 
-    // globals
-    prog_->setUniformValue("time", time);
-    prog_->setUniformValue("ambientLightIntensity", ambientLightIntensity);
+    // point light: index into the lights of the FrameData block, -1: all of them
+    assert(light_pass == allLights || light_pass < unsigned(FrameUniforms::maxLights));
+    uniforms_->set("lightPass", light_pass == allLights? -1 : int(light_pass));
 
-    // point light
-    assert(light_pass>=0 && light_pass<lights.size());
-    prog_->setUniformValue("light.position_WC", lights[light_pass].position_WC);
-    prog_->setUniformValue("light.intensity", lights[light_pass].color * lights[light_pass].intensity);
-    prog_->setUniformValue("light.pass", light_pass);
+    // all parameters are in the material table, see pack()
+    assert(materialIndex >= 0);
+    uniforms_->set("materialIndex", materialIndex);
 
-    // Phong
-    prog_->setUniformValue("phong.k_ambient",  phong.k_ambient);
-    prog_->setUniformValue("phong.k_diffuse",  phong.k_diffuse);
-    prog_->setUniformValue("phong.k_specular", phong.k_specular);
-    prog_->setUniformValue("phong.shininess",  phong.shininess);
+}
 
+void PhongMaterial::pack(MaterialTable::Record &record) const
+{
+    for(int i=0; i<3; i++) {
+        record.k_ambient[i]  = phong.k_ambient[i];
+        record.k_diffuse[i]  = phong.k_diffuse[i];
+        record.k_specular[i] = phong.k_specular[i];
+    }
+    record.k_specular[3] = phong.shininess;
 }
 
 
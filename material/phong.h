@@ -1,6 +1,7 @@
 #pragma once
 
 #include "material/material.h"
+#include "render/materialtable.h"
 
 #include <QOpenGLTexture>
 
@@ -9,19 +10,18 @@ class PhongMaterial : public Material {
 public:
 
     // constructor requires existing shader program
-    PhongMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : Material(prog)
-    {
-        lights.push_back(PointLight()); // make sure there is at least one light
-    }
+    PhongMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : Material(prog) {}
 
     // bind underlying shader program and set required uniforms
     void apply(unsigned int light_pass = 0) override;
 
-    // animation time
-    float time = 0.0;
+    // write the material parameters into a record of the material table
+    virtual void pack(MaterialTable::Record& record) const;
 
-    // ambient light
-    QVector3D ambientLightIntensity = QVector3D(0.3f,0.3f,0.3f);
+    // index of this material's record, assigned by MaterialTable::add()
+    int materialIndex = -1;
+
+    // note: lights, ambient light and time are per-frame data, see FrameUniforms
 
     // properties of the Phong aspects of the material
     struct Phong {
@@ -31,13 +31,6 @@ public:
         float     shininess  = 80; // middle-ish
     } phong;
 
-    struct PointLight {
-        QVector4D position_WC = QVector4D(0,1,5,1);
-        QVector3D color = QVector3D(1,1,1);
-        float intensity = 0.5;
-    };
-    std::vector<PointLight> lights;
-
 };
 
 
@@ -1,22 +1,21 @@
 #include "postmaterial.h"
-#include "QOpenGLFunctions"
+#include "render/glstate.h"
+#include "render/textureunits.h"
 
 void PostMaterial::apply(unsigned int)
 {
-    prog_->bind();
+    GLState::current().useProgram(*prog_);
 
-    // bind texture manually using its OpenGL ID
-    QOpenGLFunctions gl(QOpenGLContext::currentContext());
-    gl.glActiveTexture(GL_TEXTURE0 + tex_unit);
-    gl.glBindTexture(GL_TEXTURE_2D, post_texture_id);
-    gl.glActiveTexture(GL_TEXTURE0 + tex_unit +1);
-    gl.glBindTexture(GL_TEXTURE_2D, post_texture_id2);
+    // bind FBO textures using their OpenGL IDs; the second one only if the filter uses it
+    auto& units = TextureUnits::current();
+    const auto screen = textureSampler_;
+    uniforms_->set("post_tex", units.bind(GL_TEXTURE_2D, GLuint(post_texture_id), screen));
+    if(uniforms_->location("post_tex2") >= 0)
+        uniforms_->set("post_tex2", units.bind(GL_TEXTURE_2D, GLuint(post_texture_id2), screen));
 
-    prog_->setUniformValue("post_tex", tex_unit);
-    prog_->setUniformValue("post_tex2", tex_unit+1);
-    prog_->setUniformValue("image_width", (GLint)image_size.width());
-    prog_->setUniformValue("image_height", (GLint)image_size.height());
-    prog_->setUniformValue("kernel_width", (GLint)kernel_size.width());
-    prog_->setUniformValue("kernel_height", (GLint)kernel_size.height());
-    prog_->setUniformValue("use_jitter", use_jitter);
+    uniforms_->set("image_width", (GLint)image_size.width());
+    uniforms_->set("image_height", (GLint)image_size.height());
+    uniforms_->set("kernel_width", (GLint)kernel_size.width());
+    uniforms_->set("kernel_height", (GLint)kernel_size.height());
+    uniforms_->set("use_jitter", use_jitter);
 }
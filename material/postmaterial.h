@@ -1,13 +1,13 @@
 #pragma once
 
 #include "material/material.h"
+#include "render/textureunits.h"
 
 class PostMaterial : public Material {
 public:
 
     // constructor requires existing shader program
-    PostMaterial(std::shared_ptr<QOpenGLShaderProgram> prog,
-                 int texunit = 10) : Material(prog), tex_unit(texunit) {}
+    PostMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : Material(prog) {}
 
     // the texture to be post processed
     GLint post_texture_id;
@@ -22,12 +22,14 @@ public:
     // use jittering of sample points?
     bool use_jitter = false;
 
-    // texture unit to be used
-    int tex_unit;
-
     // bind underlying shader program and set required uniforms
     void apply(unsigned int light_pass = 0) override;
 
+protected:
+
+    // filtering of the post processing textures
+    TextureUnits::Sampler textureSampler_ = TextureUnits::Sampler::Screen;
+
 };
 
 
@@ -0,0 +1,79 @@
+#include "material/separableblur.h"
+#include "render/glstate.h"
+
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::exp, std::ceil
+
+using namespace std;
+
+namespace {
+
+// uniform names of the tap arrays, "weights[i]" / "offsets[i]"
+const vector<string>& uniformNames(const char* array)
+{
+    static vector<string> weights, offsets;
+    auto& names = array[0] == 'w'? weights : offsets;
+    if(names.empty())
+        for(int i=0; i<SeparableBlurMaterial::maxTaps; i++)
+            names.push_back(string(array) + "[" + to_string(i) + "]");
+    return names;
+}
+
+}
+
+SeparableBlurMaterial::SeparableBlurMaterial(std::shared_ptr<QOpenGLShaderProgram> prog,
+                                             Kernel kernel, bool vertical)
+    : PostMaterial(prog), kernel_(kernel), vertical_(vertical)
+{
+    // taps fall between texels
+    textureSampler_ = TextureUnits::Sampler::ScreenLinear;
+}
+
+void SeparableBlurMaterial::computeTaps(Kernel kernel, int n,
+                                        vector<float> &weights, vector<float> &offsets)
+{
+    // discrete one-sided weights w[0..r] of the symmetric kernel
+    const int maxRadius = 2 * (maxTaps - 1);
+    int r = min(max(n, 1) / 2, maxRadius);
+    vector<float> w(size_t(r) + 1, 1.0f);
+    if(kernel == Kernel::Gaussian) {
+        float sigma = (max(n, 1) - 1) / 6.0f;
+        r = sigma > 0? min(int(ceil(3 * sigma)), maxRadius) : 0;
+        w.assign(size_t(r) + 1, 1.0f);
+        for(int i=1; i<=r; i++)
+            w[i] = exp(-0.5f * i * i / (sigma * sigma));
+    }
+
+    float sum = w[0];
+    for(int i=1; i<=r; i++)
+        sum += 2 * w[i];
+
+    // center tap, then pairs of texels (i, i+1) merged into one fetch at their weighted center
+    weights.assign(1, w[0] / sum);
+    offsets.assign(1, 0.0f);
+    for(int i=1; i<=r; i+=2) {
+        float a = w[i], b = i+1 <= r? w[i+1] : 0.0f;
+        weights.push_back((a + b) / sum);
+        offsets.push_back((i * a + (i+1) * b) / (a + b));
+    }
+}
+
+void SeparableBlurMaterial::apply(unsigned int light_pass)
+{
+    PostMaterial::apply(light_pass);
+
+    int n = vertical_? kernel_size.height() : kernel_size.width();
+    if(n != tapsFor_) {
+        computeTaps(kernel_, n, weights_, offsets_);
+        tapsFor_ = n;
+    }
+
+    const auto& weightNames = uniformNames("weights");
+    const auto& offsetNames = uniformNames("offsets");
+    uniforms_->set("vertical", vertical_);
+    uniforms_->set("taps", GLint(weights_.size()));
+    for(size_t i=0; i<weights_.size(); i++) {
+        uniforms_->set(weightNames[i].c_str(), weights_[i]);
+        uniforms_->set(offsetNames[i].c_str(), offsets_[i]);
+    }
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "material/postmaterial.h"
+
+#include <string> // std::string
+#include <vector> // std::vector
+
+/*
+ *  One direction of a separable blur (box or Gaussian), for any kernel
+ *  size. The weights are computed on the CPU whenever the kernel size
+ *  changes. Neighbouring taps are folded into a single bilinear fetch
+ *  between the two texels, so a kernel of radius r takes about r+1
+ *  fetches per pixel instead of 2r+1.
+ *
+ *  The horizontal and the vertical pass are two materials sharing
+ *  one program, drawn one after the other through an intermediate image.
+ *
+ */
+class SeparableBlurMaterial : public PostMaterial {
+public:
+
+    enum class Kernel { Box, Gaussian };
+
+    // constructor requires existing shader program
+    SeparableBlurMaterial(std::shared_ptr<QOpenGLShaderProgram> prog, Kernel kernel, bool vertical);
+
+    // taps of the shader, incl. the center; limits the radius to 2*(maxTaps-1)
+    static const int maxTaps = 16;
+
+    /*
+     *  one-sided taps for a kernel of n pixels (kernel_size), center first.
+     *  Gaussian: sigma = (n-1)/6, so that n covers +/- 3 sigma.
+     */
+    static void computeTaps(Kernel kernel, int n,
+                            std::vector<float>& weights, std::vector<float>& offsets);
+
+    // bind program, texture (filtered) and the taps
+    void apply(unsigned int light_pass = 0) override;
+
+protected:
+
+    Kernel kernel_;
+    bool vertical_;
+
+    // taps for the kernel size they were computed for
+    int tapsFor_ = -1;
+    std::vector<float> weights_, offsets_;
+};
@@ -1,9 +1,10 @@
 #include "skyboxmaterial.h"
+#include "render/glstate.h"
+#include "render/textureunits.h"
 
 void SkyBoxMaterial::apply(unsigned int)
 {
-    prog_->bind();
-    prog_->setUniformValue("cubeMap", tex_unit);
-    prog_->setUniformValue("skybox.intensity_scale", intensity_scale);
-    texture->bind(tex_unit);
+    GLState::current().useProgram(*prog_);
+    uniforms_->set("cubeMap", TextureUnits::current().bind(*texture, TextureUnits::Sampler::CubeMap));
+    uniforms_->set("skybox.intensity_scale", intensity_scale);
 }
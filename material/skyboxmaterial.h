@@ -7,8 +7,8 @@ class SkyBoxMaterial : public Material {
 public:
 
     // constructor requires existing shader program
-    SkyBoxMaterial(std::shared_ptr<QOpenGLShaderProgram> prog, int texunit = 0)
-        : Material(prog), tex_unit(texunit) {}
+    SkyBoxMaterial(std::shared_ptr<QOpenGLShaderProgram> prog)
+        : Material(prog) {}
 
     // the cube map
     std::shared_ptr<QOpenGLTexture> texture;
@@ -16,9 +16,6 @@ public:
     // intensity scaling factor
     float intensity_scale = 1.0;
 
-    // texture unit to be used
-    int tex_unit;
-
     // bind underlying shader program and set required uniforms
     void apply(unsigned int light_pass = 0) override;
 
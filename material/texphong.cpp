@@ -1,6 +1,11 @@
 #include "material/texphong.h"
+#include "render/textureunits.h"
+#include "render/lightclusters.h"
+#include "render/shadowmaps.h"
 #include <assert.h>
 
+using namespace std;
+
 
 void TexturedPhongMaterial::apply(unsigned int light_pass)
 {
@@ -8,51 +13,96 @@ void TexturedPhongMaterial::apply(unsigned int light_pass)
     // first do all that regular Phong does
     PhongMaterial::apply(light_pass);
 
-    // then take care of the textures
-    prog_->setUniformValue("tex.useDiffuseTexture", tex.useDiffuseTexture);
-    prog_->setUniformValue("tex.useEmissiveTexture", tex.useEmissiveTexture);
-    prog_->setUniformValue("tex.useGlossTexture", tex.useGlossTexture);
-    prog_->setUniformValue("tex.useEnvironmentTexture", tex.useEnvironmentTexture);
-
-    int unit = tex.tex_unit;
+    // then take care of the textures; all flags and factors are in the material table.
+    // units are assigned by TextureUnits, textures still bound from earlier draws stay there.
+    auto& units = TextureUnits::current();
+    const auto mipmapped = TextureUnits::Sampler::Mipmapped;
 
-    if(tex.useDiffuseTexture) {
-        prog_->setUniformValue("diffuseTexture", unit);
-        tex.diffuseTexture->bind(unit++);
-    }
-    if(tex.useEmissiveTexture) {
-        prog_->setUniformValue("emissiveTexture", unit);
-        tex.emissiveTexture->bind(unit++);
-    }
-    if(tex.useGlossTexture) {
-        prog_->setUniformValue("glossTexture", unit);
-        tex.glossTexture->bind(unit++);
-    }
-    if(tex.useEnvironmentTexture) {
-        prog_->setUniformValue("environmentTexture", unit);
-        tex.environmentTexture->bind(unit++);
-    }
-    prog_->setUniformValue("tex.emissive_scale", tex.emissive_scale);
+    if(tex.useDiffuseTexture)
+        uniforms_->set("diffuseTexture", units.bind(*tex.diffuseTexture, mipmapped));
+    if(tex.useEmissiveTexture)
+        uniforms_->set("emissiveTexture", units.bind(*tex.emissiveTexture, mipmapped));
+    if(tex.useGlossTexture)
+        uniforms_->set("glossTexture", units.bind(*tex.glossTexture, mipmapped));
+    if(tex.useEnvironmentTexture)
+        uniforms_->set("environmentTexture", units.bind(*tex.environmentTexture,
+                                                        TextureUnits::Sampler::CubeMap));
 
     // bump & displacement mapping
-    prog_->setUniformValue("bump.use", bump.use);
-    if(bump.use) {
-        prog_->setUniformValue("bump.scale", bump.scale);
-        prog_->setUniformValue("bump.debug", bump.debug);
-        prog_->setUniformValue("bumpTexture", unit); bump.tex->bind(unit++);
-    }
-    prog_->setUniformValue("displacement.use", displacement.use);
-    if(displacement.use) {
-        prog_->setUniformValue("displacement.scale", displacement.scale);
-        prog_->setUniformValue("displacementTexture", unit); displacement.tex->bind(unit++);
-    }
+    if(bump.use)
+        uniforms_->set("bumpTexture", units.bind(*bump.tex, mipmapped));
+    if(displacement.use)
+        uniforms_->set("displacementTexture", units.bind(*displacement.tex, mipmapped));
 
-    // environment mapping
-    prog_->setUniformValue("envmap.k_mirror",   envmap.k_mirror);
-    prog_->setUniformValue("envmap.k_refract",  envmap.k_refract);
-    prog_->setUniformValue("envmap.refract_ratio",  envmap.refract_ratio);
+    // clustered lights
+    if(clusteredLights && lightClusters)
+        lightClusters->apply(*uniforms_);
+
+    // shadow maps
+    if(shadowMaps && !writeGBuffer)
+        shadowMaps->apply(*uniforms_);
 
 }
 
+vector<string> TexturedPhongMaterial::featureNames()
+{
+    return { "DIFFUSE_TEXTURE", "EMISSIVE_TEXTURE", "GLOSS_TEXTURE",
+             "ENVIRONMENT_TEXTURE", "BUMP_MAPPING", "DISPLACEMENT_MAPPING",
+             "GBUFFER_OUTPUT", "CLUSTERED_LIGHTS", "SHADOWS" };
+}
 
+uint32_t TexturedPhongMaterial::features() const
+{
+    uint32_t f = 0;
+    if(tex.useDiffuseTexture)     f |= 1u << DiffuseTexture;
+    if(tex.useEmissiveTexture)    f |= 1u << EmissiveTexture;
+    if(tex.useGlossTexture)       f |= 1u << GlossTexture;
+    if(tex.useEnvironmentTexture) f |= 1u << EnvironmentTexture;
+    if(bump.use)                  f |= 1u << BumpMapping;
+    if(displacement.use)          f |= 1u << DisplacementMapping;
+    if(writeGBuffer)              f |= 1u << GBufferOutput;
+    if(clusteredLights)           f |= 1u << ClusteredLights;
+    if(shadowMaps && !writeGBuffer) f |= 1u << Shadows;
+    return f;
+}
 
+void TexturedPhongMaterial::selectProgram()
+{
+    if(!variants_)
+        return;
+
+    auto prog = variants_->program(features());
+    if(prog && prog != prog_)
+        setProgram(prog);
+}
+
+bool TexturedPhongMaterial::programUpToDate() const
+{
+    return !variants_ || variants_->program(features()) == prog_;
+}
+
+void TexturedPhongMaterial::pack(MaterialTable::Record &record) const
+{
+    PhongMaterial::pack(record);
+
+    // texturing
+    record.textures[0] = tex.useDiffuseTexture;
+    record.textures[1] = tex.useEmissiveTexture;
+    record.textures[2] = tex.useGlossTexture;
+    record.textures[3] = tex.useEnvironmentTexture;
+    record.k_refract[3] = tex.emissive_scale;
+
+    // bump & displacement mapping
+    record.mapping[0] = bump.use;
+    record.mapping[1] = bump.debug != 0.0f;
+    record.mapping[2] = displacement.use;
+    record.scales[0]  = bump.scale;
+    record.scales[1]  = displacement.scale;
+
+    // environment mapping
+    for(int i=0; i<3; i++) {
+        record.k_mirror[i]  = envmap.k_mirror[i];
+        record.k_refract[i] = envmap.k_refract[i];
+    }
+    record.k_mirror[3] = envmap.refract_ratio;
+}
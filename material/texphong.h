@@ -1,15 +1,51 @@
 #pragma once
 
 #include "material/phong.h"
+#include "render/shaderpermutations.h"
+
+class LightClusters;
+class ShadowMaps;
 
 
 class TexturedPhongMaterial : public PhongMaterial {
 public:
 
-    // constructor requires existing shader program
-    TexturedPhongMaterial(std::shared_ptr<QOpenGLShaderProgram> prog, int texunit = 0)
-        : PhongMaterial(prog)
-    { tex.tex_unit = texunit; }
+    // constructor requires existing shader program, compiled for the features in use
+    TexturedPhongMaterial(std::shared_ptr<QOpenGLShaderProgram> prog)
+        : PhongMaterial(prog) {}
+
+    // use a specialized program variant for the textures in use, see selectProgram().
+    // fallback is used until the first variant is compiled (e.g. plain Phong).
+    TexturedPhongMaterial(std::shared_ptr<ShaderPermutations> variants,
+                          std::shared_ptr<QOpenGLShaderProgram> fallback)
+        : PhongMaterial(fallback), variants_(variants) {}
+
+    // optional features, compiled into the shaders (bit i of features())
+    enum Feature {
+        DiffuseTexture, EmissiveTexture, GlossTexture,
+        EnvironmentTexture, BumpMapping, DisplacementMapping,
+        GBufferOutput, ClusteredLights, Shadows
+    };
+
+    // #define names of the features, in the order of Feature
+    static std::vector<std::string> featureNames();
+
+    // features used by the current settings
+    uint32_t features() const;
+
+    // write the G-buffer instead of shading (deferred pipeline, see GBuffer)
+    bool writeGBuffer = false;
+
+    // shade with the lights binned in lightClusters instead of the frame's lights
+    // (forward, all lights in a single pass); lightClusters must be set
+    bool clusteredLights = false;
+    const LightClusters* lightClusters = nullptr;
+
+    // shadows of the lights in shadowMaps, if set (forward shading only)
+    const ShadowMaps* shadowMaps = nullptr;
+
+    // is the program for the current settings in use, i.e. not still being compiled?
+    bool programUpToDate() const;
 
     // texturing-specific properties
     struct Textures {
@@ -22,7 +58,6 @@ public:
         std::shared_ptr<QOpenGLTexture> glossTexture;
         std::shared_ptr<QOpenGLTexture> environmentTexture;
         float emissive_scale = 1.0;
-        int tex_unit;     // first texture unit to be used
     } tex;
 
     // bump mapping
@@ -50,5 +85,20 @@ public:
     // bind underlying shader program and set required uniforms
     virtual void apply(unsigned int light_pass = 0) override;
 
+    // switch to the program variant for features(), if there are variants;
+    // the current program is kept while the variant is being compiled
+    virtual void selectProgram() override;
+
+    // displacement mapping moves vertices
+    virtual bool displacesVertices() const override { return displacement.use; }
+
+    // Phong parameters plus texturing, bump and environment mapping settings
+    virtual void pack(MaterialTable::Record& record) const override;
+
+protected:
+
+    // program variants of the textured Phong shaders, if any
+    std::shared_ptr<ShaderPermutations> variants_;
+
 };
 
@@ -0,0 +1,9 @@
+#include "material/velocity.h"
+#include "render/glstate.h"
+
+void VelocityMaterial::apply(unsigned int)
+{
+    GLState::current().useProgram(*prog_);
+    uniforms_->set("modelViewProjectionMatrix", modelViewProjection);
+    uniforms_->set("previousModelViewProjectionMatrix", previousModelViewProjection);
+}
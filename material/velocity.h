@@ -0,0 +1,25 @@
+#pragma once
+
+#include "material/material.h"
+
+#include <QMatrix4x4>
+
+/*
+ *  Writes the screen-space motion of each pixel since the last frame
+ *  (in texture coordinates, rg), for the velocity motion blur. Both
+ *  matrices are set by the caller before each draw.
+ *
+ */
+class VelocityMaterial : public Material {
+public:
+
+    // constructor requires existing shader program
+    VelocityMaterial(std::shared_ptr<QOpenGLShaderProgram> prog) : Material(prog) {}
+
+    // model-view-projection of this frame and of the last one
+    QMatrix4x4 modelViewProjection, previousModelViewProjection;
+
+    // bind underlying shader program and set both matrices
+    void apply(unsigned int light_pass = 0) override;
+
+};
@@ -1,6 +1,8 @@
 #include "geometrybuffers.h"
 
 #include "objloader.h"
+#include "render/glstate.h"
+#include "render/glfunctions.h"
 
 #include <iostream>
 #include <assert.h>
@@ -16,47 +18,58 @@ GeometryBuffers::bbox() const
 }
 
 void
-GeometryBuffers::bind(QOpenGLVertexArrayObject& vao, QOpenGLShaderProgram& prog) const
+GeometryBuffers::bind(QOpenGLVertexArrayObject& vao) const
 {
-    vao.bind();
-    prog.bind();
+    auto& gl = glCore();
+    auto& state = GLState::current();
+    state.bindVertexArray(vao.objectId());
+
+    auto attribute = [&gl](GLuint location, int size) {
+        gl.glEnableVertexAttribArray(location);
+        gl.glVertexAttribPointer(location, size, GL_FLOAT, GL_FALSE, 0, nullptr);
+    };
 
     if(position_->numElements()) {
         position_->bind();
-        prog.enableAttributeArray("position_MC");
-        prog.setAttributeBuffer("position_MC", GL_FLOAT, 0, 3);
+        attribute(Position, 3);
     }
 
     if(normal_->numElements()) {
         normal_->bind();
-        prog.enableAttributeArray("normal_MC");
-        prog.setAttributeBuffer("normal_MC", GL_FLOAT, 0, 3);
+        attribute(Normal, 3);
     }
 
     if(texcoord_ && texcoord_->numElements()) {
         texcoord_->bind();
-        prog.enableAttributeArray("texcoord");
-        prog.setAttributeBuffer("texcoord", GL_FLOAT, 0, 2);
+        attribute(TexCoord, 2);
     }
 
     if(tangent_ && tangent_->numElements()) {
         tangent_->bind();
-        prog.enableAttributeArray("tangent_MC");
-        prog.setAttributeBuffer("tangent_MC", GL_FLOAT, 0, 3);
+        attribute(Tangent, 3);
     }
 
     if(bitangent_ && bitangent_->numElements()) {
         bitangent_->bind();
-        prog.enableAttributeArray("bitangent_MC");
-        prog.setAttributeBuffer("bitangent_MC", GL_FLOAT, 0, 3);
+        attribute(Bitangent, 3);
     }
 
     // do not forget: bind index buffer!
     if(index_->numElements())
         index_->bind();
 
-    vao.release();
+    state.bindVertexArray(0);
+
+}
 
+void
+GeometryBuffers::bindAttributeLocations(QOpenGLShaderProgram &prog)
+{
+    prog.bindAttributeLocation("position_MC",  Position);
+    prog.bindAttributeLocation("normal_MC",    Normal);
+    prog.bindAttributeLocation("texcoord",     TexCoord);
+    prog.bindAttributeLocation("tangent_MC",   Tangent);
+    prog.bindAttributeLocation("bitangent_MC", Bitangent);
 }
 
 void GeometryBuffers::generateTriangleTangents(const std::vector<QVector3D>& position,
@@ -167,7 +180,7 @@ void GeometryBuffers::generateTriangleTangents(const std::vector<QVector3D>& pos
 }
 
 
-GeometryOBJ::GeometryOBJ(const string& filename)
+ObjLoader GeometryOBJ::load(const string& filename)
 {
     // create loader and load vertex data from OBJ file
     ObjLoader loader;
@@ -175,7 +188,16 @@ GeometryOBJ::GeometryOBJ(const string& filename)
     loader.setLoadTextureCoordinatesEnabled(true);
     if (!loader.load(filename.c_str()))
         qFatal("Could not load mesh");
+    return loader;
+}
+
+GeometryOBJ::GeometryOBJ(const string& filename)
+    : GeometryOBJ(load(filename))
+{
+}
 
+GeometryOBJ::GeometryOBJ(const ObjLoader& loader)
+{
     // copy data from the loader's data structures into OpenGL buffer(s)
     position_ = make_unique<VertexBuffer<QVector3D>>(loader.vertices());
     normal_   = make_unique<VertexBuffer<QVector3D>>(loader.normals());
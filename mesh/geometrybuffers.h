@@ -19,12 +19,16 @@
  *  (VBO) and an element buffer.
  *
  *  When using the bind() method, vertex data will be bound
- *  to the following uniform names:
- *  vertex position     -> uniform vec3 position_MC
- *  vertex normal       -> uniform vec3 normal_MC
- *  tangent             -> uniform vec3 tangent_MC
- *  bitangent           -> uniform vec3 bitangent_MC
- *  texture coordinates -> uniform vec2 texcoord
+ *  to fixed attribute locations, which bindAttributeLocations()
+ *  assigns to the following names in every program:
+ *  vertex position     -> 0, in vec3 position_MC
+ *  vertex normal       -> 1, in vec3 normal_MC
+ *  texture coordinates -> 2, in vec2 texcoord
+ *  tangent             -> 3, in vec3 tangent_MC
+ *  bitangent           -> 4, in vec3 bitangent_MC
+ *
+ *  So a VAO does not depend on the program, and can be used
+ *  with all variants of a shader (see ShaderPermutations).
  *
  *  The suffix _MC indicates model coordinates.
  *
@@ -39,10 +43,18 @@ class GeometryBuffers {
 
 public:
 
+    // fixed vertex attribute locations, the same in all programs
+    enum Attribute : GLuint { Position = 0, Normal = 1, TexCoord = 2, Tangent = 3, Bitangent = 4 };
+
+    /*
+     *  bind buffer objects to the fixed attribute locations. bindings are recorded in specified VAO.
+     */
+    virtual void bind(QOpenGLVertexArrayObject& vao) const;
+
     /*
-     *  bind buffer objects to uniforms in a program. bindings are recorded in specified VAO.
+     *  assign the fixed locations to the attribute names; call before linking a program
      */
-    virtual void bind(QOpenGLVertexArrayObject& vao, QOpenGLShaderProgram& prog) const;
+    static void bindAttributeLocations(QOpenGLShaderProgram& prog);
 
     /*
      *  ask for bounding box (without considering transformations)
@@ -78,6 +90,8 @@ protected:
                                   const std::vector<unsigned int>& index);
 };
 
+class ObjLoader;
+
 class GeometryOBJ :public GeometryBuffers {
 
 public:
@@ -86,4 +100,15 @@ public:
      */
     GeometryOBJ(const std::string& filename);
 
+    /*
+     * create buffers from an already loaded OBJ model, see load()
+     */
+    GeometryOBJ(const ObjLoader& loader);
+
+    /*
+     * parse an OBJ model file, without creating any OpenGL objects.
+     * Does not need an OpenGL context, can be called from worker threads.
+     */
+    static ObjLoader load(const std::string& filename);
+
 };
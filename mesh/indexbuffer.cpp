@@ -1,4 +1,5 @@
 #include "indexbuffer.h"
+#include "render/glstate.h"
 
 
 IndexBuffer::IndexBuffer(const std::vector<IndexBuffer::T>& data,
@@ -15,6 +16,10 @@ IndexBuffer::IndexBuffer(const std::vector<IndexBuffer::T>& data,
     if(!buffer_.create())
         qFatal("Unable to create vertex buffer");
 
+    // binding GL_ELEMENT_ARRAY_BUFFER changes the bound VAO, and Mesh::draw()
+    // leaves its VAO bound. Unbind first so no mesh loses its indices.
+    GLState::current().bindVertexArray(0);
+
     // set usage pattern and copy data into buffer
     buffer_.bind();
     buffer_.setUsagePattern(usage);
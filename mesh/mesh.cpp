@@ -1,6 +1,9 @@
 
 #include "mesh.h"
 #include "objloader.h"
+#include "render/renderstats.h"
+#include "render/glstate.h"
+#include "render/textureunits.h"
 
 #include <iostream>
 #include <assert.h>
@@ -31,22 +34,31 @@ Mesh::Mesh(shared_ptr<GeometryBuffers> geometry,
     if (!vao_.create())
         qFatal("Mesh: unable to create VAO");
 
-    geometry_->bind(vao_, material_->program());
+    geometry_->bind(vao_);
 
 }
 
 void Mesh::draw(unsigned int light_pass)
+{
+    draw(*material_, light_pass);
+}
+
+void Mesh::draw(Material& material, unsigned int light_pass)
 {
 
     // qDebug() << "drawing mesh, bbox max extent = " << geometry_->bbox().maxExtent();
 
-    // set the right shader, set all uniforms to their correct values
-    material_->apply(light_pass);
+    // set the right shader, set all uniforms to their correct values.
+    // textures bound for earlier draws may now be replaced.
+    TextureUnits::current().nextDraw();
+    material.apply(light_pass);
 
     // bind VAO with all required buffer states, then draw
-    vao_.bind();
+    // the VAO stays bound, the next mesh usually binds its own anyway.
+    // IndexBuffer unbinds it before touching GL_ELEMENT_ARRAY_BUFFER.
+    GLState::current().bindVertexArray(vao_.objectId());
     glDrawElements(GL_TRIANGLES, GLsizei(geometry_->numIndices()), GL_UNSIGNED_INT, Q_NULLPTR);
-    vao_.release();
+    RenderStats::current().drawCalls++;
 }
 
 void Mesh::replaceMaterial(std::shared_ptr<Material> material)
@@ -54,14 +66,8 @@ void Mesh::replaceMaterial(std::shared_ptr<Material> material)
     if(!material)
         qFatal("Mesh: cannot replace material with no material");
 
-    // discard old VAO, create new one
-    vao_.destroy();
-    if (!vao_.create())
-        qFatal("Mesh: unable to create VAO");
-
-    // set new material and bind it in the new VAO
+    // attribute locations are the same in all programs, the VAO stays valid
     material_ = material;
-    geometry_->bind(vao_, material_->program());
 
 }
 
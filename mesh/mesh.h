@@ -11,7 +11,8 @@
  *  Multiple mesh instances can share the same geometry information.
  *
  *  The Mesh creates an OpenGL Vertex Array Object (VAO) to
- *  represent the mapping of buffers to the material's uniform names.
+ *  represent the mapping of buffers to the fixed attribute locations
+ *  (see GeometryBuffers::bindAttributeLocations()).
  *
  */
 
@@ -33,13 +34,16 @@ public:
     // Draw the mesh using the associated material
     void draw(unsigned int light_pass = 0);
 
+    // Draw the geometry using another material (e.g. for depth-only passes)
+    void draw(Material& material, unsigned int light_pass = 0);
+
     // access geometry
     std::shared_ptr<GeometryBuffers> geometry() const { return geometry_; }
 
     // access material
     std::shared_ptr<Material> material() const { return material_; }
 
-    // replace material, fill VAO with new bindings
+    // replace material, the VAO is kept
     void replaceMaterial(std::shared_ptr<Material> material);
 
     // do not copy meshes, please use constructor to generate copy
@@ -36,6 +36,37 @@ HEADERS      += \
     navigator/modeltrackball.h \
     navigator/rotate_y.h \
     material/skyboxmaterial.h \
+    material/depthonly.h \
+    material/separableblur.h \
+    material/dualfilter.h \
+    material/motionblur.h \
+    material/velocity.h \
+    material/deferredlight.h \
+    render/glfunctions.h \
+    render/renderstats.h \
+    render/occlusionquery.h \
+    render/frustum.h \
+    render/drawlist.h \
+    render/frameuniforms.h \
+    render/drawuniforms.h \
+    render/materialtable.h \
+    render/uniformcache.h \
+    render/glstate.h \
+    render/textureunits.h \
+    render/shaderpermutations.h \
+    render/programcompiler.h \
+    render/gbuffer.h \
+    render/lightclusters.h \
+    render/lightbounds.h \
+    render/gputimer.h \
+    render/shadowatlas.h \
+    render/shadowmaps.h \
+    render/rendertargetpool.h \
+    render/rendergraph.h \
+    render/posteffectcomposer.h \
+    render/asyncreadback.h \
+    jobs/jobsystem.h \
+    jobs/jobbenchmark.h \
     skybox.h
 
 # C++ SOURCE FILES TO BE COMPILED AND LINKED TOGETHER
@@ -65,6 +96,37 @@ SOURCES      += \
     geometry/parametric.cpp \
     navigator/modeltrackball.cpp \
     material/skyboxmaterial.cpp \
+    material/depthonly.cpp \
+    material/separableblur.cpp \
+    material/dualfilter.cpp \
+    material/motionblur.cpp \
+    material/velocity.cpp \
+    material/deferredlight.cpp \
+    render/glfunctions.cpp \
+    render/renderstats.cpp \
+    render/occlusionquery.cpp \
+    render/frustum.cpp \
+    render/drawlist.cpp \
+    render/frameuniforms.cpp \
+    render/drawuniforms.cpp \
+    render/materialtable.cpp \
+    render/uniformcache.cpp \
+    render/glstate.cpp \
+    render/textureunits.cpp \
+    render/shaderpermutations.cpp \
+    render/programcompiler.cpp \
+    render/gbuffer.cpp \
+    render/lightclusters.cpp \
+    render/lightbounds.cpp \
+    render/gputimer.cpp \
+    render/shadowatlas.cpp \
+    render/shadowmaps.cpp \
+    render/rendertargetpool.cpp \
+    render/rendergraph.cpp \
+    render/posteffectcomposer.cpp \
+    render/asyncreadback.cpp \
+    jobs/jobsystem.cpp \
+    jobs/jobbenchmark.cpp \
     skybox.cpp
 
 # RESOURCE FILES TO BE PROCESSED BY QT
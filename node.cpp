@@ -22,11 +22,18 @@ Node::draw(const Camera &cam, unsigned int light_pass, QMatrix4x4 parent_transfo
         child->draw(cam, light_pass, transform);
 
     if(mesh) {
+        // skip the mesh if it is known to be occluded, else draw inside query / conditional render
+        if(occlusionQuery && !occlusionQuery->begin(cam, transform, mesh->geometry()->bbox(), light_pass))
+            return;
+
         // set uniforms for model matrix, modelview matrix, MVP matrix, normal matrix, etc.
         cam.setShaderTransformationMatrices(*mesh->material(), transform);
 
         // issues actual draw call, draw mesh using current uniform values
         mesh->draw(light_pass);
+
+        if(occlusionQuery)
+            occlusionQuery->end();
     }
 
 }
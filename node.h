@@ -2,6 +2,7 @@
 
 #include "mesh/mesh.h"
 #include "camera.h"
+#include "render/occlusionquery.h"
 #include <QMatrix4x4>
 
 /*
@@ -34,11 +35,14 @@ public:
     // vector of child nodes
     std::vector<std::shared_ptr<Node>> children;
 
+    // optional: hardware occlusion query for this node's mesh (nullptr = always draw)
+    std::shared_ptr<OcclusionQuery> occlusionQuery;
+
     /*
      * draw the node by:
      * - calculating and setting the model matrix
      * - using the camera to set all transformation matrices in the material
-     * - actually drawing the mesh
+     * - actually drawing the mesh (unless the occlusion query says it is hidden)
      */
     virtual void draw(const Camera& cam,
                       unsigned int light_pass = 0,
@@ -0,0 +1,126 @@
+#include "render/asyncreadback.h"
+#include "render/glfunctions.h"
+
+#include <cstring> // std::memcpy
+
+using namespace std;
+
+AsyncReadback::AsyncReadback(Ready ready)
+    : ready_(move(ready))
+{
+    for(auto& s : slots_)
+        glCore().glGenBuffers(1, &s.buffer);
+}
+
+AsyncReadback::~AsyncReadback()
+{
+    // workers may still read mapped memory
+    for(auto& s : slots_)
+        JobSystem::instance().wait(s.conversion);
+
+    if(!QOpenGLContext::currentContext())
+        return;
+    auto& gl = glCore();
+    for(auto& s : slots_) {
+        if(s.fence)
+            gl.glDeleteSync(s.fence);
+        if(s.state == State::Converting) {
+            gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, s.buffer);
+            gl.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        }
+        gl.glDeleteBuffers(1, &s.buffer);
+    }
+    gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+bool AsyncReadback::request(GLuint framebuffer, const QSize &size, unsigned int id,
+                            const QString &label)
+{
+    Slot* slot = nullptr;
+    for(auto& s : slots_) {
+        if(s.state == State::Free) {
+            slot = &s;
+            break;
+        }
+    }
+    if(!slot)
+        return false;
+
+    auto& gl = glCore();
+    size_t bytes = size_t(size.width()) * size_t(size.height()) * 4;
+
+    GLint previous;
+    gl.glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previous);
+    gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+    gl.glReadBuffer(GL_COLOR_ATTACHMENT0);
+
+    // copy into the PBO; the call returns without waiting for the GPU
+    gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, slot->buffer);
+    if(slot->capacity != bytes) {
+        gl.glBufferData(GL_PIXEL_PACK_BUFFER, GLsizeiptr(bytes), nullptr, GL_STREAM_READ);
+        slot->capacity = bytes;
+    }
+    gl.glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    gl.glReadPixels(0, 0, size.width(), size.height(), GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    gl.glBindFramebuffer(GL_READ_FRAMEBUFFER, GLuint(previous));
+
+    slot->fence = gl.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    slot->state = State::Reading;
+    slot->size = size;
+    slot->id = id;
+    slot->label = label;
+    return true;
+}
+
+void AsyncReadback::poll()
+{
+    auto& gl = glCore();
+
+    for(auto& s : slots_) {
+
+        // copy done on the GPU: map, and convert on a worker (bottom-up rows to top-down)
+        if(s.state == State::Reading) {
+            GLenum status = gl.glClientWaitSync(s.fence, 0, 0);
+            if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+                continue;
+            gl.glDeleteSync(s.fence);
+            s.fence = nullptr;
+
+            gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, s.buffer);
+            auto pixels = static_cast<const uchar*>(
+                        gl.glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, GLsizeiptr(s.capacity),
+                                            GL_MAP_READ_BIT));
+            gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+            if(!pixels) {
+                s.state = State::Free;
+                continue;
+            }
+
+            Slot* slot = &s;
+            s.state = State::Converting;
+            s.conversion = JobSystem::instance().submit([slot, pixels] {
+                int w = slot->size.width(), h = slot->size.height();
+                QImage image(w, h, QImage::Format_RGBX8888);
+                for(int y=0; y<h; y++)
+                    memcpy(image.scanLine(h-1-y), pixels + size_t(y) * size_t(w) * 4, size_t(w) * 4);
+                slot->image = image;
+            });
+            continue;
+        }
+
+        // image built: recycle the PBO, deliver the image
+        if(s.state == State::Converting && s.conversion->isDone()) {
+            gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, s.buffer);
+            gl.glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+            gl.glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+            s.conversion = nullptr;
+            s.state = State::Free;
+            QImage image = s.image;
+            s.image = QImage();
+            if(ready_)
+                ready_(s.id, s.label, image);
+        }
+    }
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include "jobs/jobsystem.h"
+
+#include <QOpenGLFunctions_3_3_Core>
+#include <QImage>
+#include <QString>
+#include <QSize>
+
+#include <functional> // std::function
+
+/*
+ *  Reads framebuffer contents back into QImages without stalling the
+ *  GL thread, e.g. for the buffer inspector ("show FBOs").
+ *
+ *  request() only queues a glReadPixels into one of a few pixel buffer
+ *  objects (PBOs), followed by a fence. poll(), once per frame, maps
+ *  the PBOs whose fence has signaled (usually a frame or two later) and
+ *  lets a JobSystem worker convert the mapped pixels into a QImage.
+ *  Once converted, the PBO is unmapped and recycled, and the image is
+ *  handed to the ready callback on the GL thread, at a later poll().
+ *
+ *  If all PBOs are busy, a request is dropped rather than waited for.
+ *
+ *  Usage (GL thread):
+ *      AsyncReadback readback([](unsigned id, QString label, QImage img) { ... });
+ *      readback.poll();                              // every frame
+ *      readback.request(fbo->handle(), fbo->size(), 0, "rendered scene");
+ *
+ */
+class AsyncReadback
+{
+public:
+
+    using Ready = std::function<void(unsigned int id, QString label, const QImage& image)>;
+
+    explicit AsyncReadback(Ready ready);
+    ~AsyncReadback();
+
+    // queue a copy of the framebuffer's color attachment 0; false if dropped
+    bool request(GLuint framebuffer, const QSize& size, unsigned int id, const QString& label);
+
+    // advance the readbacks in flight, deliver the finished images
+    void poll();
+
+    // do not copy, owns OpenGL buffers
+    AsyncReadback(const AsyncReadback&) = delete;
+    AsyncReadback& operator=(const AsyncReadback&) = delete;
+
+protected:
+
+    enum class State { Free, Reading, Converting };
+
+    // one PBO and the readback using it
+    struct Slot {
+        GLuint buffer = 0;
+        size_t capacity = 0;                  // bytes allocated
+        State state = State::Free;
+        GLsync fence = nullptr;               // Reading: copy done on the GPU
+        JobSystem::TaskHandle conversion;     // Converting: worker building the image
+        QSize size;
+        unsigned int id = 0;
+        QString label;
+        QImage image;
+    };
+
+    static const int numSlots = 4;
+    Slot slots_[numSlots];
+
+    Ready ready_;
+};
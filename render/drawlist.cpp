@@ -0,0 +1,189 @@
+#include "render/drawlist.h"
+#include "render/frustum.h"
+#include "render/renderstats.h"
+#include "render/drawuniforms.h"
+#include "render/lightbounds.h"
+#include "jobs/jobsystem.h"
+
+#include <algorithm> // std::stable_sort, std::min
+#include <cstring>   // std::memcpy
+
+using namespace std;
+
+void DrawList::append(const DrawList &other)
+{
+    items.insert(items.end(), other.items.begin(), other.items.end());
+}
+
+void DrawList::sort()
+{
+    stable_sort(items.begin(), items.end(),
+                [](const DrawItem& a, const DrawItem& b) { return a.sortKey < b.sortKey; });
+}
+
+void DrawList::submit(const Camera &cam, unsigned int light_pass,
+                      const DrawUniforms* drawData, const LightBounds* light) const
+{
+    submit_(cam, light_pass, drawData, light, nullptr);
+}
+
+void DrawList::submitDepth(const Camera &cam, Material &depthMaterial,
+                           const DrawUniforms *drawData) const
+{
+    submit_(cam, 0, drawData, nullptr, &depthMaterial);
+}
+
+void DrawList::submit_(const Camera &cam, unsigned int light_pass, const DrawUniforms *drawData,
+                       const LightBounds *light, Material *depthMaterial) const
+{
+    for(size_t i=0; i<items.size(); i++) {
+        const auto& item = items[i];
+
+        // outside the light's range: nothing to add in this pass
+        if(light && !light->intersects(item.mesh->geometry()->bbox(), item.modelMatrix)) {
+            RenderStats::current().lightCulled++;
+            continue;
+        }
+
+        // skip the mesh if it is known to be occluded, else draw inside query / conditional render
+        auto& query = item.node->occlusionQuery;
+        if(query && !query->begin(cam, item.modelMatrix, item.mesh->geometry()->bbox(), light_pass))
+            continue;
+
+        Material& material = depthMaterial && !item.mesh->material()->displacesVertices()?
+                    *depthMaterial : *item.mesh->material();
+        if(drawData)
+            drawData->bind(i);
+        else
+            cam.setShaderTransformationMatrices(material, item.modelMatrix);
+        item.mesh->draw(material, light_pass);
+
+        if(query)
+            query->end();
+    }
+}
+
+namespace {
+
+// everything a traversal job needs to know, shared read-only between jobs
+struct TraversalContext {
+    Frustum frustum;
+    QMatrix4x4 viewMatrix;
+    bool cull;
+};
+
+// output of a single traversal job
+struct TraversalResult {
+    DrawList list;
+    size_t culled = 0;
+};
+
+/*
+ * sort key, most significant first:
+ * 16 bit program, 16 bit material, 32 bit view distance (front to back).
+ * Identity bits are only used for grouping, collisions do no harm.
+ */
+uint64_t makeSortKey(const Mesh& mesh, float distance)
+{
+    uint64_t program  = mesh.material()->program().programId() & 0xffff;
+    uint64_t material = (reinterpret_cast<uintptr_t>(mesh.material().get()) >> 4) & 0xffff;
+
+    // non-negative IEEE floats compare like unsigned integers
+    distance = max(distance, 0.0f);
+    uint32_t depth;
+    memcpy(&depth, &distance, sizeof(depth));
+
+    return (program << 48) | (material << 32) | depth;
+}
+
+// add a node's own mesh, if it is potentially visible
+void emitItem(const Node& node, const QMatrix4x4& transform,
+              const TraversalContext& ctx, TraversalResult& out)
+{
+    if(!node.mesh)
+        return;
+
+    const auto& bbox = node.mesh->geometry()->bbox();
+    if(ctx.cull && !ctx.frustum.intersects(bbox, transform)) {
+        out.culled++;
+        return;
+    }
+
+    float distance = -(ctx.viewMatrix * (transform * bbox.center())).z();
+    out.list.items.push_back({ &node, node.mesh.get(), transform,
+                               makeSortKey(*node.mesh, distance) });
+}
+
+// depth-first traversal of a subtree, parent transform accumulated from above
+void traverse(const Node& node, const QMatrix4x4& parent,
+              const TraversalContext& ctx, TraversalResult& out)
+{
+    QMatrix4x4 transform = parent * node.transformation;
+
+    for(const auto& child : node.children)
+        traverse(*child, transform, ctx, out);
+
+    emitItem(node, transform, ctx, out);
+}
+
+} // namespace
+
+void DrawListBuilder::build(const Node &root, const Camera &cam, DrawList &result)
+{
+    const TraversalContext ctx = { Frustum(cam.projectionMatrix() * cam.viewMatrix()),
+                                   cam.viewMatrix(), frustumCulling };
+    TraversalResult main;
+
+    // subtree roots still to be traversed, with their parent's transformation
+    vector<pair<const Node*, QMatrix4x4>> frontier = { { &root, QMatrix4x4() } };
+
+    // expand the graph breadth-first on this thread, until there are enough
+    // independent subtrees to keep all workers busy. Small scenes are
+    // completely processed here.
+    auto& jobs = JobSystem::instance();
+    size_t workers = parallel? jobs.numWorkers() + 1 : 1;
+    size_t target = workers > 1? 4 * workers : 1;
+    while(!frontier.empty() && frontier.size() < target) {
+        decltype(frontier) next;
+        for(const auto& f : frontier) {
+            QMatrix4x4 transform = f.second * f.first->transformation;
+            emitItem(*f.first, transform, ctx, main);
+            for(const auto& child : f.first->children)
+                next.push_back({ child.get(), transform });
+        }
+        frontier.swap(next);
+    }
+
+    size_t numJobs = 1;
+    if(workers == 1 || frontier.size() < minParallelSubtrees) {
+
+        for(const auto& f : frontier)
+            traverse(*f.first, f.second, ctx, main);
+
+    } else {
+
+        // a few subtrees per job, so the workers can balance the load by stealing
+        const size_t grain = max(frontier.size() / (4 * workers), size_t(1));
+        numJobs = (frontier.size() + grain - 1) / grain;
+        vector<TraversalResult> partial(numJobs);
+        jobs.parallelFor(0, frontier.size(), grain,
+                         [&frontier, &ctx, &partial, grain](size_t from, size_t to) {
+            for(size_t i=from; i<to; i++)
+                traverse(*frontier[i].first, frontier[i].second, ctx, partial[from / grain]);
+        });
+
+        // merge per-job lists in job order, so the result is deterministic
+        for(const auto& p : partial) {
+            main.list.append(p.list);
+            main.culled += p.culled;
+        }
+    }
+
+    result.items.swap(main.list.items);
+    result.sort();
+
+    auto& stats = RenderStats::current();
+    stats.drawItems += result.items.size();
+    stats.frustumCulled += main.culled;
+    stats.prepJobs += numJobs;
+}
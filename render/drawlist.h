@@ -0,0 +1,102 @@
+#pragma once
+
+#include "node.h"
+#include "camera.h"
+
+class DrawUniforms;
+class LightBounds;
+
+#include <QMatrix4x4>
+#include <vector>  // std::vector
+#include <cstdint> // uint64_t
+
+/*
+ *  One mesh to be drawn in the current frame, with its accumulated
+ *  model matrix. Pointers are only valid during the frame.
+ *
+ */
+struct DrawItem
+{
+    const Node* node;        // node the mesh belongs to (occlusion query etc.)
+    Mesh* mesh;              // mesh to be drawn
+    QMatrix4x4 modelMatrix;  // accumulated model-to-world transformation
+    uint64_t sortKey;        // draw order: program, material, front to back
+};
+
+/*
+ *  Flat list of everything to be drawn in a frame.
+ *
+ *  Built on the CPU (possibly in parallel, see DrawListBuilder)
+ *  before any OpenGL call is made, then submitted by the GL thread
+ *  once per light pass.
+ *
+ */
+class DrawList
+{
+public:
+
+    std::vector<DrawItem> items;
+
+    void clear() { items.clear(); }
+
+    // append all items of another list
+    void append(const DrawList& other);
+
+    // order items by sort key, to minimize state changes and overdraw
+    void sort();
+
+    /*
+     *  Issue draw calls for all items (GL thread only). If drawData is
+     *  given, it must hold this list's matrices (see DrawUniforms::upload()),
+     *  and each draw binds its slice instead of setting matrix uniforms.
+     *  If light is given, items out of the light's reach are skipped.
+     */
+    void submit(const Camera& cam, unsigned int light_pass = 0,
+                const DrawUniforms* drawData = nullptr,
+                const LightBounds* light = nullptr) const;
+
+    /*
+     *  Depth-only pass (GL thread only): draw all items with depthMaterial,
+     *  except for items whose material moves vertices, which are drawn
+     *  with their own material. Occlusion queries are issued as in pass 0.
+     *  Color writes must be disabled by the caller.
+     */
+    void submitDepth(const Camera& cam, Material& depthMaterial,
+                     const DrawUniforms* drawData = nullptr) const;
+
+protected:
+
+    // draw all items; with their own material if depthMaterial is nullptr
+    void submit_(const Camera& cam, unsigned int light_pass, const DrawUniforms* drawData,
+                 const LightBounds* light, Material* depthMaterial) const;
+
+};
+
+/*
+ *  CPU frame preparation: walks the scene graph, accumulates
+ *  transformations, culls meshes against the view frustum and
+ *  builds sort keys. Produces a sorted DrawList; no OpenGL calls.
+ *
+ *  Independent subtrees are traversed in parallel on the JobSystem,
+ *  each job writing into its own draw list; the lists are merged
+ *  afterwards. Small scenes are traversed on the calling thread only.
+ *
+ */
+class DrawListBuilder
+{
+public:
+
+    // traverse the graph below root and fill result (previous contents are discarded)
+    void build(const Node& root, const Camera& cam, DrawList& result);
+
+    // cull meshes outside the view frustum?
+    bool frustumCulling = true;
+
+    // use worker threads for large scenes?
+    bool parallel = true;
+
+    // minimum number of independent subtrees before jobs are used
+    size_t minParallelSubtrees = 16;
+
+};
+
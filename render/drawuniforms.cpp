@@ -0,0 +1,135 @@
+#include "render/drawuniforms.h"
+#include "render/drawlist.h"
+#include "render/renderstats.h"
+
+#include <cstring> // std::memcpy
+
+using namespace std;
+
+DrawUniforms::DrawUniforms()
+    : fences_(framesInFlight, nullptr)
+{
+    auto& gl = glCore();
+    gl.glGenBuffers(1, &ubo_);
+
+    // records are bound by offset, which must be suitably aligned
+    GLint alignment = 256;
+    gl.glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+    stride_ = (sizeof(Std140) + alignment - 1) / alignment * alignment;
+
+    reserve(256);
+}
+
+DrawUniforms::~DrawUniforms()
+{
+    if(!QOpenGLContext::currentContext())
+        return;
+
+    auto& gl = glCore();
+    for(auto fence : fences_)
+        if(fence)
+            gl.glDeleteSync(fence);
+    gl.glDeleteBuffers(1, &ubo_);
+}
+
+void DrawUniforms::reserve(size_t n)
+{
+    if(n <= capacity_)
+        return;
+
+    capacity_ = capacity_ ? capacity_ : 1;
+    while(capacity_ < n)
+        capacity_ *= 2;
+
+    // new storage: the driver keeps the old one alive as long as the GPU needs it,
+    // so the fences guarding it are not of interest anymore
+    auto& gl = glCore();
+    for(auto& fence : fences_) {
+        if(fence)
+            gl.glDeleteSync(fence);
+        fence = nullptr;
+    }
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    gl.glBufferData(GL_UNIFORM_BUFFER, GLsizeiptr(framesInFlight * capacity_ * stride_),
+                    nullptr, GL_STREAM_DRAW);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+void DrawUniforms::upload(const Camera &cam, const DrawList &list)
+{
+    const auto& items = list.items;
+    if(items.empty())
+        return;
+
+    reserve(items.size());
+    region_ = (region_ + 1) % framesInFlight;
+
+    auto& gl = glCore();
+
+    // the GPU finished with this region frames ago, normally no waiting here
+    GLsync& fence = fences_[region_];
+    if(fence) {
+        gl.glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, GLuint64(1000000000));
+        gl.glDeleteSync(fence);
+        fence = nullptr;
+    }
+
+    GLintptr offset = GLintptr(region_ * capacity_ * stride_);
+    GLsizeiptr size = GLsizeiptr(items.size() * stride_);
+
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    auto* data = static_cast<char*>(gl.glMapBufferRange(GL_UNIFORM_BUFFER, offset, size,
+                                                         GL_MAP_WRITE_BIT |
+                                                         GL_MAP_INVALIDATE_RANGE_BIT |
+                                                         GL_MAP_UNSYNCHRONIZED_BIT));
+    if(!data)
+        qFatal("DrawUniforms: could not map uniform buffer");
+
+    const QMatrix4x4 view = cam.viewMatrix(), projection = cam.projectionMatrix();
+    for(size_t i=0; i<items.size(); i++) {
+
+        const QMatrix4x4& m = items[i].modelMatrix;
+        QMatrix4x4 mv  = view * m;
+        QMatrix4x4 mvp = projection * mv;
+        QMatrix3x3 n   = mv.normalMatrix();
+
+        Std140 record;
+        memcpy(record.modelMatrix, m.constData(), sizeof(record.modelMatrix));
+        memcpy(record.modelViewMatrix, mv.constData(), sizeof(record.modelViewMatrix));
+        memcpy(record.modelViewProjectionMatrix, mvp.constData(), sizeof(record.modelViewProjectionMatrix));
+        for(int col=0; col<3; col++) {
+            memcpy(&record.normalMatrix[4*col], n.constData() + 3*col, 3 * sizeof(float));
+            record.normalMatrix[4*col+3] = 0;
+        }
+
+        memcpy(data + i * stride_, &record, sizeof(record));
+    }
+
+    gl.glUnmapBuffer(GL_UNIFORM_BUFFER);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    RenderStats::current().drawDataBytes += size_t(size);
+}
+
+void DrawUniforms::bind(size_t slot) const
+{
+    GLintptr offset = GLintptr((region_ * capacity_ + slot) * stride_);
+    glCore().glBindBufferRange(GL_UNIFORM_BUFFER, bindingPoint, ubo_, offset, sizeof(Std140));
+}
+
+void DrawUniforms::endFrame()
+{
+    auto& gl = glCore();
+    GLsync& fence = fences_[region_];
+    if(fence)
+        gl.glDeleteSync(fence);
+    fence = gl.glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+void DrawUniforms::bindProgram(QOpenGLShaderProgram &prog)
+{
+    auto& gl = glCore();
+    GLuint index = gl.glGetUniformBlockIndex(prog.programId(), "DrawData");
+    if(index != GL_INVALID_INDEX)
+        gl.glUniformBlockBinding(prog.programId(), index, bindingPoint);
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "camera.h"
+#include "render/glfunctions.h"
+
+#include <QMatrix4x4>
+#include <QOpenGLShaderProgram>
+
+#include <vector>  // std::vector
+
+class DrawList;
+
+/*
+ *  Per-draw transformation data (M, MV, MVP, N) of all items of a
+ *  draw list, streamed into one uniform buffer per frame. Each draw
+ *  then binds its own slice of the buffer with glBindBufferRange()
+ *  instead of setting four matrix uniforms by name.
+ *
+ *  The buffer is a ring of framesInFlight regions. Each frame writes
+ *  the next region (unsynchronized mapping), and a fence is placed
+ *  after the last draw that reads it. Before a region is reused, its
+ *  fence is waited for, which normally has long been signaled, so the
+ *  GPU is never stalled by the upload.
+ *
+ *  GLSL side (std140 layout):
+ *
+ *      layout(std140) uniform DrawData {
+ *          mat4 modelMatrix;
+ *          mat4 modelViewMatrix;
+ *          mat4 modelViewProjectionMatrix;
+ *          mat3 normalMatrix;
+ *      };
+ *
+ *  Meshes drawn without a draw list (post processing, sky box,
+ *  occlusion proxies) keep using the matrix uniforms set by Camera.
+ *
+ */
+class DrawUniforms
+{
+public:
+
+    // binding point of the DrawData block, in all programs
+    static const unsigned int bindingPoint = 1;
+
+    // regions of the ring buffer, i.e. frames the GPU may lag behind
+    static const int framesInFlight = 3;
+
+    DrawUniforms();
+    ~DrawUniforms();
+
+    // write the matrices of all items into the next region (item index = slot)
+    void upload(const Camera& cam, const DrawList& list);
+
+    // bind the data of slot i for the next draw call
+    void bind(size_t slot) const;
+
+    // all draws reading the current region have been issued
+    void endFrame();
+
+    // connect the program's DrawData block (if any) to the binding point
+    static void bindProgram(QOpenGLShaderProgram& prog);
+
+    // do not copy, owns an OpenGL buffer
+    DrawUniforms(const DrawUniforms&) = delete;
+    DrawUniforms& operator=(const DrawUniforms&) = delete;
+
+protected:
+
+    // memory layout of one record, must match the GLSL declaration (std140)
+    struct Std140 {
+        float modelMatrix[16];
+        float modelViewMatrix[16];
+        float modelViewProjectionMatrix[16];
+        float normalMatrix[12]; // mat3: three vec4 columns
+    };
+    static_assert(sizeof(Std140) == 240, "DrawData does not match std140 layout");
+
+    // (re-)allocate the buffer for at least n records per region
+    void reserve(size_t n);
+
+    unsigned int ubo_ = 0;
+
+    // distance between records, multiple of GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+    size_t stride_ = 256;
+
+    // records per region
+    size_t capacity_ = 0;
+
+    // region written by the last upload(), and its fence
+    int region_ = 0;
+    std::vector<GLsync> fences_;
+};
+
@@ -0,0 +1,71 @@
+#include "render/frameuniforms.h"
+#include "render/glfunctions.h"
+
+#include <algorithm> // std::min
+#include <cstring>   // std::memcpy
+
+namespace {
+
+void copyMatrix(float* dst, const QMatrix4x4& m)
+{
+    // QMatrix4x4 stores column-major, like GLSL
+    std::memcpy(dst, m.constData(), 16 * sizeof(float));
+}
+
+}
+
+FrameUniforms::FrameUniforms()
+{
+    auto& gl = glCore();
+    gl.glGenBuffers(1, &ubo_);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    gl.glBufferData(GL_UNIFORM_BUFFER, sizeof(Std140), nullptr, GL_DYNAMIC_DRAW);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+FrameUniforms::~FrameUniforms()
+{
+    if(ubo_ && QOpenGLContext::currentContext())
+        glCore().glDeleteBuffers(1, &ubo_);
+}
+
+void FrameUniforms::upload(const Camera &cam)
+{
+    Std140 data = {};
+
+    // matrices: inverse and product calculated once per frame, not per draw
+    copyMatrix(data.viewMatrix, cam.viewMatrix());
+    copyMatrix(data.inverseViewMatrix, cam.viewMatrix().inverted());
+    copyMatrix(data.projectionMatrix, cam.projectionMatrix());
+    copyMatrix(data.viewProjectionMatrix, cam.projectionMatrix() * cam.viewMatrix());
+
+    for(int i=0; i<3; i++)
+        data.ambientLightIntensity[i] = ambientLightIntensity[i];
+    data.time = time;
+
+    data.numLights = std::min(int(lights.size()), int(maxLights));
+    for(int i=0; i<data.numLights; i++) {
+        QVector3D intensity = lights[i].color * lights[i].intensity;
+        for(int k=0; k<4; k++)
+            data.lights[i].position_WC[k] = lights[i].position_WC[k];
+        for(int k=0; k<3; k++)
+            data.lights[i].intensity[k] = intensity[k];
+        data.lights[i].intensity[3] = lights[i].range;
+    }
+
+    // orphan the old storage, so we never wait for draws still reading it
+    auto& gl = glCore();
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    gl.glBufferData(GL_UNIFORM_BUFFER, sizeof(Std140), nullptr, GL_DYNAMIC_DRAW);
+    gl.glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(Std140), &data);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    gl.glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ubo_);
+}
+
+void FrameUniforms::bindProgram(QOpenGLShaderProgram &prog)
+{
+    auto& gl = glCore();
+    GLuint index = gl.glGetUniformBlockIndex(prog.programId(), "FrameData");
+    if(index != GL_INVALID_INDEX)
+        gl.glUniformBlockBinding(prog.programId(), index, bindingPoint);
+}
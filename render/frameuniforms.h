@@ -0,0 +1,97 @@
+#pragma once
+
+#include "camera.h"
+
+#include <QVector3D>
+#include <QVector4D>
+#include <QOpenGLShaderProgram>
+
+#include <vector>  // std::vector
+#include <cstdint> // int32_t
+
+/*
+ *  Per-frame data that is the same for every draw call: camera
+ *  matrices, time and lights. Written once per frame into a uniform
+ *  buffer object (UBO), which is bound to a fixed binding point that
+ *  every program's FrameData block is connected to (see bindProgram()).
+ *
+ *  GLSL side (std140 layout, block members are global names):
+ *
+ *      struct FrameLight {
+ *          vec4 position_WC;
+ *          vec4 intensity;              // rgb: color * intensity, w: range
+ *      };
+ *      layout(std140) uniform FrameData {
+ *          mat4  viewMatrix;
+ *          mat4  inverseViewMatrix;
+ *          mat4  projectionMatrix;
+ *          mat4  viewProjectionMatrix;
+ *          vec3  ambientLightIntensity;
+ *          float time;
+ *          int   numLights;
+ *          FrameLight lights[8];
+ *      };
+ *
+ */
+class FrameUniforms
+{
+public:
+
+    // binding point of the FrameData block, in all programs
+    static const unsigned int bindingPoint = 0;
+
+    // size of the lights array in the shaders
+    static const int maxLights = 8;
+
+    struct PointLight {
+        QVector4D position_WC = QVector4D(0,1,5,1);
+        QVector3D color = QVector3D(1,1,1);
+        float intensity = 0.5;
+        float range = 0;  // contribution fades to zero at this distance; <= 0: unbounded
+    };
+
+    // lights of the scene, at most maxLights are uploaded
+    std::vector<PointLight> lights;
+
+    // ambient light
+    QVector3D ambientLightIntensity = QVector3D(0.3f,0.3f,0.3f);
+
+    // animation time in seconds
+    float time = 0.0;
+
+    FrameUniforms();
+    ~FrameUniforms();
+
+    // write all per-frame data into the UBO and bind it (once per frame)
+    void upload(const Camera& cam);
+
+    // connect the program's FrameData block (if any) to the binding point
+    static void bindProgram(QOpenGLShaderProgram& prog);
+
+    // do not copy, owns an OpenGL buffer
+    FrameUniforms(const FrameUniforms&) = delete;
+    FrameUniforms& operator=(const FrameUniforms&) = delete;
+
+protected:
+
+    // memory layout of the block, must match the GLSL declaration (std140)
+    struct Std140 {
+        float viewMatrix[16];
+        float inverseViewMatrix[16];
+        float projectionMatrix[16];
+        float viewProjectionMatrix[16];
+        float ambientLightIntensity[3];
+        float time;
+        int32_t numLights;
+        int32_t padding_[3];
+        struct {
+            float position_WC[4];
+            float intensity[4];
+        } lights[maxLights];
+    };
+    static_assert(sizeof(Std140) == 288 + maxLights * 32, "FrameData does not match std140 layout");
+
+    // OpenGL buffer object
+    unsigned int ubo_ = 0;
+};
+
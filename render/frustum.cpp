@@ -0,0 +1,49 @@
+#include "render/frustum.h"
+#include "mesh/bbox.h"
+
+#include <cmath>
+
+Frustum::Frustum(const QMatrix4x4 &viewProjection)
+{
+    const QVector4D r0 = viewProjection.row(0), r1 = viewProjection.row(1);
+    const QVector4D r2 = viewProjection.row(2), r3 = viewProjection.row(3);
+
+    planes_ = {{ r3 + r0, r3 - r0, r3 + r1, r3 - r1, r3 + r2, r3 - r2 }};
+
+    // normalize, so plane distances are real distances (needed for spheres)
+    for(auto& p : planes_) {
+        float len = p.toVector3D().length();
+        if(len > 0)
+            p /= len;
+    }
+}
+
+bool Frustum::intersects(const BoundingBox &bbox, const QMatrix4x4 &modelMatrix) const
+{
+    // transform the box center, and find the extents of the transformed box
+    // along the coordinate axes (absolute values of the linear part)
+    QVector3D center = modelMatrix * bbox.center();
+    QVector3D r = bbox.radii();
+    QVector3D extent;
+    for(int i=0; i<3; i++)
+        extent[i] = std::fabs(modelMatrix(i,0)) * r.x() +
+                    std::fabs(modelMatrix(i,1)) * r.y() +
+                    std::fabs(modelMatrix(i,2)) * r.z();
+
+    for(const auto& p : planes_) {
+        float dist = p.x()*center.x() + p.y()*center.y() + p.z()*center.z() + p.w();
+        float proj = std::fabs(p.x())*extent.x() + std::fabs(p.y())*extent.y() + std::fabs(p.z())*extent.z();
+        if(dist < -proj)
+            return false;
+    }
+    return true;
+}
+
+bool Frustum::intersects(const QVector3D &center, float radius) const
+{
+    for(const auto& p : planes_) {
+        if(QVector4D::dotProduct(p, QVector4D(center, 1)) < -radius)
+            return false;
+    }
+    return true;
+}
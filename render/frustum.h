@@ -0,0 +1,33 @@
+#pragma once
+
+#include <QMatrix4x4>
+#include <QVector4D>
+#include <array>
+
+class BoundingBox;
+
+/*
+ *  View frustum as six planes, extracted from a combined
+ *  view-projection matrix (Gribb & Hartmann). Plane normals
+ *  point to the inside of the frustum.
+ *
+ */
+class Frustum
+{
+public:
+
+    // planes in the coordinate system that viewProjection maps from (usually WC)
+    explicit Frustum(const QMatrix4x4& viewProjection = QMatrix4x4());
+
+    // is a model-space bounding box, transformed by modelMatrix, (partially) inside?
+    bool intersects(const BoundingBox& bbox, const QMatrix4x4& modelMatrix) const;
+
+    // is a sphere (same coordinate system as the planes) (partially) inside?
+    bool intersects(const QVector3D& center, float radius) const;
+
+protected:
+
+    // left, right, bottom, top, near, far
+    std::array<QVector4D,6> planes_;
+};
+
@@ -0,0 +1,60 @@
+#include "render/gbuffer.h"
+#include "render/glfunctions.h"
+#include "render/glstate.h"
+
+#include <assert.h>
+
+using namespace std;
+
+void GBuffer::resize(const QSize &size)
+{
+    if(fbo_ && fbo_->size() == size)
+        return;
+
+    QOpenGLFramebufferObjectFormat format;
+    format.setAttachment(QOpenGLFramebufferObject::Depth);
+    format.setInternalTextureFormat(GL_RGBA8);
+
+    fbo_ = make_unique<QOpenGLFramebufferObject>(size, format);
+    fbo_->addColorAttachment(size, GL_RGBA16F);
+    fbo_->addColorAttachment(size, GL_RGBA16F);
+    if(!fbo_->isValid())
+        qFatal("GBuffer: could not create framebuffer object");
+
+    // creating the textures changed the texture bindings
+    GLState::current().invalidate();
+}
+
+void GBuffer::bind()
+{
+    assert(fbo_);
+    fbo_->bind();
+
+    // draw buffers are FBO state, but setting them is cheap
+    static const GLenum buffers[NumTargets] = {
+        GL_COLOR_ATTACHMENT0, GL_COLOR_ATTACHMENT1, GL_COLOR_ATTACHMENT2
+    };
+    glCore().glDrawBuffers(NumTargets, buffers);
+}
+
+void GBuffer::release()
+{
+    assert(fbo_);
+    fbo_->release();
+}
+
+GLuint GBuffer::texture(Target target) const
+{
+    assert(fbo_);
+    return fbo_->textures()[target];
+}
+
+void GBuffer::blitDepth(QOpenGLFramebufferObject &target)
+{
+    assert(fbo_ && fbo_->size() == target.size());
+
+    // blits are affected by the scissor test
+    GLState::current().disable(GL_SCISSOR_TEST);
+    QOpenGLFramebufferObject::blitFramebuffer(&target, fbo_.get(),
+                                              GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+}
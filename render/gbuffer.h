@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QOpenGLFramebufferObject>
+
+#include <memory> // std::unique_ptr
+
+/*
+ *  Compact G-buffer for deferred shading, three color targets and depth:
+ *
+ *  Albedo       RGBA8    diffuse color, shininess / 255
+ *  NormalDepth  RGBA16F  surface normal (WC), linear view depth (-z_EC)
+ *  Emission     RGBA16F  ambient + emissive + environment color,
+ *                        specular intensity
+ *
+ *  The geometry pass writes all targets at once (textured_phong.frag
+ *  with GBUFFER_OUTPUT); the light passes reconstruct the position
+ *  from the view depth, see deferred_light.frag. The depth buffer is
+ *  a renderbuffer; it is copied into the lit frame, so light volumes
+ *  can be depth tested against the scene.
+ *
+ */
+class GBuffer
+{
+public:
+
+    // color targets, in order of their attachments / fragment outputs
+    enum Target { Albedo = 0, NormalDepth = 1, Emission = 2, NumTargets };
+
+    // (re)create the targets if the size has changed
+    void resize(const QSize& size);
+
+    // size of the targets, empty before the first resize()
+    QSize size() const { return fbo_? fbo_->size() : QSize(); }
+
+    // bind for the geometry pass, drawing into all targets
+    void bind();
+
+    // bind the default framebuffer again
+    void release();
+
+    // texture of a target, for the light passes
+    GLuint texture(Target target) const;
+
+    // copy the depth buffer into another FBO of the same size
+    void blitDepth(QOpenGLFramebufferObject& target);
+
+protected:
+
+    std::unique_ptr<QOpenGLFramebufferObject> fbo_;
+
+};
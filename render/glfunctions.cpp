@@ -0,0 +1,22 @@
+#include "render/glfunctions.h"
+
+#include <assert.h>
+
+GLCoreFunctions& glCore()
+{
+    // cache the resolved functions, looking them up is a hash lookup in Qt
+    static thread_local QOpenGLContext* context = nullptr;
+    static thread_local GLCoreFunctions* functions = nullptr;
+
+    auto current = QOpenGLContext::currentContext();
+    assert(current);
+
+    if(current != context) {
+        functions = current->versionFunctions<GLCoreFunctions>();
+        if(!functions || !functions->initializeOpenGLFunctions())
+            qFatal("OpenGL core profile functions not available");
+        context = current;
+    }
+
+    return *functions;
+}
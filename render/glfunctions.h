@@ -0,0 +1,17 @@
+#pragma once
+
+#include <QOpenGLContext>
+#include <QOpenGLFunctions_3_3_Core>
+
+/*
+ *  QOpenGLFunctions only covers the OpenGL ES 2.0 subset. Everything
+ *  beyond that (queries, conditional rendering, uniform buffers, ...)
+ *  is taken from the desktop core profile functions of the current
+ *  context. The app requests a 3.3 core context, see main.cpp.
+ *
+ */
+using GLCoreFunctions = QOpenGLFunctions_3_3_Core;
+
+// core functions of the current context, resolved once per context
+GLCoreFunctions& glCore();
+
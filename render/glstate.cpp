@@ -0,0 +1,118 @@
+#include "render/glstate.h"
+#include "render/glfunctions.h"
+#include "render/renderstats.h"
+#include "render/textureunits.h"
+
+#include <algorithm> // std::find_if
+#include <memory>    // std::unique_ptr
+
+using namespace std;
+
+const GLuint GLState::unknown;
+
+GLState& GLState::current()
+{
+    // one tracker per context, like the core functions
+    static thread_local QOpenGLContext* context = nullptr;
+    static thread_local unique_ptr<GLState> state;
+
+    auto ctx = QOpenGLContext::currentContext();
+    if(ctx != context || !state) {
+        state = make_unique<GLState>();
+        context = ctx;
+    }
+    return *state;
+}
+
+bool GLState::count(bool changed)
+{
+    auto& stats = RenderStats::current();
+    if(changed)
+        stats.stateChanges++;
+    else
+        stats.stateChangesSkipped++;
+    return changed;
+}
+
+void GLState::useProgram(GLuint id)
+{
+    if(count(program_ != id))
+        glCore().glUseProgram(program_ = id);
+}
+
+void GLState::bindVertexArray(GLuint id)
+{
+    if(count(vao_ != id))
+        glCore().glBindVertexArray(vao_ = id);
+}
+
+void GLState::bindTexture(int unit, GLenum target, GLuint id)
+{
+    auto& gl = glCore();
+
+    // only 2D and cube map bindings are tracked
+    vector<GLuint>* bound = nullptr;
+    if(target == GL_TEXTURE_2D)
+        bound = &textures2D_;
+    else if(target == GL_TEXTURE_CUBE_MAP)
+        bound = &texturesCube_;
+
+    if(bound && bound->size() <= size_t(unit))
+        bound->resize(size_t(unit) + 1, unknown);
+    if(bound && !count((*bound)[unit] != id))
+        return;
+
+    if(activeUnit_ != GLuint(unit))
+        gl.glActiveTexture(GL_TEXTURE0 + (activeUnit_ = GLuint(unit)));
+    gl.glBindTexture(target, id);
+    if(bound)
+        (*bound)[unit] = id;
+}
+
+void GLState::set(GLenum cap, bool on)
+{
+    auto c = find_if(caps_.begin(), caps_.end(),
+                     [cap](const pair<GLenum,bool>& known) { return known.first == cap; });
+
+    // not known yet: store the opposite, so the call goes through
+    if(c == caps_.end())
+        c = caps_.insert(caps_.end(), { cap, !on });
+
+    if(!count(c->second != on))
+        return;
+
+    c->second = on;
+    if(on)
+        glCore().glEnable(cap);
+    else
+        glCore().glDisable(cap);
+}
+
+bool GLState::isEnabled(GLenum cap)
+{
+    for(const auto& c : caps_)
+        if(c.first == cap)
+            return c.second;
+
+    bool on = glCore().glIsEnabled(cap);
+    caps_.push_back({cap, on});
+    return on;
+}
+
+void GLState::depthFunc(GLenum func)
+{
+    if(count(depthFunc_ != func))
+        glCore().glDepthFunc(depthFunc_ = func);
+}
+
+void GLState::blendFunc(GLenum src, GLenum dst)
+{
+    if(count(blendSrc_ != src || blendDst_ != dst))
+        glCore().glBlendFunc(blendSrc_ = src, blendDst_ = dst);
+}
+
+void GLState::invalidate()
+{
+    *this = GLState();
+    TextureUnits::current().invalidate();
+}
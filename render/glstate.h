@@ -0,0 +1,71 @@
+#pragma once
+
+#include <QOpenGLShaderProgram>
+#include <QOpenGLTexture>
+
+#include <utility> // std::pair
+#include <vector>  // std::vector
+
+/*
+ *  Shadow copy of the OpenGL state that changes most often while
+ *  drawing: bound program, VAO, textures, enabled capabilities, depth
+ *  and blend functions. Setting a value that is already current does
+ *  not reach the driver. Calls that went through and calls that were
+ *  skipped are counted in RenderStats.
+ *
+ *  The draw path (materials, Camera, Mesh, SkyBox, Scene) changes this
+ *  state only through the tracker; materials get their texture units
+ *  from TextureUnits, which binds through the tracker. Code that changes it behind the
+ *  tracker's back (Qt objects binding themselves, e.g. while creating
+ *  FBOs, textures or VAOs) must be followed by invalidate().
+ *
+ */
+class GLState
+{
+public:
+
+    // state of the current context, created on first use
+    static GLState& current();
+
+    // glUseProgram()
+    void useProgram(GLuint id);
+    void useProgram(const QOpenGLShaderProgram& prog) { useProgram(prog.programId()); }
+
+    // glBindVertexArray()
+    void bindVertexArray(GLuint id);
+
+    // glActiveTexture() + glBindTexture()
+    void bindTexture(int unit, GLenum target, GLuint id);
+    void bindTexture(int unit, const QOpenGLTexture& tex)
+    { bindTexture(unit, GLenum(tex.target()), tex.textureId()); }
+
+    // glEnable() / glDisable() / glIsEnabled()
+    void set(GLenum cap, bool on);
+    void enable(GLenum cap) { set(cap, true); }
+    void disable(GLenum cap) { set(cap, false); }
+    bool isEnabled(GLenum cap);
+
+    // glDepthFunc(), glBlendFunc()
+    void depthFunc(GLenum func);
+    void blendFunc(GLenum src, GLenum dst);
+
+    // forget everything, the next call of each kind goes to the driver
+    void invalidate();
+
+protected:
+
+    // marks a value that is not known
+    static const GLuint unknown = GLuint(-1);
+
+    // count a call that went through (true) or was skipped (false)
+    static bool count(bool changed);
+
+    GLuint program_ = unknown;
+    GLuint vao_ = unknown;
+    GLuint activeUnit_ = unknown;
+    std::vector<GLuint> textures2D_, texturesCube_;  // per unit
+    std::vector<std::pair<GLenum,bool>> caps_;       // known capabilities
+    GLenum depthFunc_ = unknown;
+    GLenum blendSrc_ = unknown, blendDst_ = unknown;
+};
+
@@ -0,0 +1,60 @@
+#include "render/gputimer.h"
+#include "render/glfunctions.h"
+
+GpuTimer::GpuTimer()
+{
+    glCore().glGenQueries(2 * numSlots, &queries_[0][0]);
+}
+
+GpuTimer::~GpuTimer()
+{
+    if(QOpenGLContext::currentContext())
+        glCore().glDeleteQueries(2 * numSlots, &queries_[0][0]);
+}
+
+void GpuTimer::begin()
+{
+    collect();
+
+    // GPU more than numSlots measurements behind: skip this one
+    active_ = !pending_[next_];
+    if(active_)
+        glCore().glQueryCounter(queries_[next_][0], GL_TIMESTAMP);
+}
+
+void GpuTimer::end()
+{
+    if(!active_)
+        return;
+
+    glCore().glQueryCounter(queries_[next_][1], GL_TIMESTAMP);
+    pending_[next_] = true;
+    next_ = (next_ + 1) % numSlots;
+    active_ = false;
+}
+
+void GpuTimer::collect()
+{
+    auto& gl = glCore();
+
+    for(int i=0; i<numSlots; i++) {
+        if(!pending_[i])
+            continue;
+
+        // the second timestamp is written last
+        GLint available = 0;
+        gl.glGetQueryObjectiv(queries_[i][1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if(!available)
+            continue;
+
+        GLuint64 t0 = 0, t1 = 0;
+        gl.glGetQueryObjectui64v(queries_[i][0], GL_QUERY_RESULT, &t0);
+        gl.glGetQueryObjectui64v(queries_[i][1], GL_QUERY_RESULT, &t1);
+        pending_[i] = false;
+
+        // exponential moving average, starting with the first measurement
+        double ms = double(t1 - t0) / 1.0e6;
+        average_ = samples_ == 0? ms : 0.95 * average_ + 0.05 * ms;
+        samples_++;
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <QOpenGLFunctions_3_3_Core>
+
+/*
+ *  GPU time of a sequence of commands, measured with timestamp queries
+ *  (glQueryCounter, OpenGL 3.3). Results are read back a few frames
+ *  later, when they are available, so measuring never stalls the
+ *  pipeline; milliseconds() is a running average.
+ *
+ *  Usage (GL thread, once per frame):
+ *      timer.begin();
+ *      ... draw calls ...
+ *      timer.end();
+ *
+ */
+class GpuTimer
+{
+public:
+
+    GpuTimer();
+    ~GpuTimer();
+
+    // put timestamps before and after the commands to be measured
+    void begin();
+    void end();
+
+    // running average over the measurements read back so far
+    double milliseconds() const { return average_; }
+
+    // number of measurements read back so far
+    size_t samples() const { return samples_; }
+
+    // do not copy, owns OpenGL queries
+    GpuTimer(const GpuTimer&) = delete;
+    GpuTimer& operator=(const GpuTimer&) = delete;
+
+protected:
+
+    // read back all measurements that have finished on the GPU
+    void collect();
+
+    // measurements in flight, a pair of timestamp queries each
+    static const int numSlots = 4;
+    GLuint queries_[numSlots][2];
+    bool pending_[numSlots] = {};
+    int next_ = 0;
+
+    // is a measurement between begin() and end()?
+    bool active_ = false;
+
+    double average_ = 0;
+    size_t samples_ = 0;
+};
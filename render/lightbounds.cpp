@@ -0,0 +1,77 @@
+#include "render/lightbounds.h"
+#include "mesh/bbox.h"
+
+#include <algorithm> // std::min, std::max
+#include <cmath>     // std::fabs, std::floor, std::ceil
+
+using namespace std;
+
+LightBounds::LightBounds(const QVector3D &position_WC, float range)
+    : center_(position_WC), range_(range)
+{
+}
+
+bool LightBounds::intersects(const BoundingBox &bbox, const QMatrix4x4 &modelMatrix) const
+{
+    if(!bounded())
+        return true;
+
+    // world-space box around the transformed box, as in Frustum::intersects()
+    QVector3D center = modelMatrix * bbox.center();
+    QVector3D r = bbox.radii();
+    float dist2 = 0;
+    for(int i=0; i<3; i++) {
+        float extent = fabs(modelMatrix(i,0)) * r.x() +
+                       fabs(modelMatrix(i,1)) * r.y() +
+                       fabs(modelMatrix(i,2)) * r.z();
+
+        // distance of the sphere center from the box along this axis
+        float d = max(fabs(center_[i] - center[i]) - extent, 0.0f);
+        dist2 += d * d;
+    }
+    return dist2 <= range_ * range_;
+}
+
+bool LightBounds::scissorRect(const Camera &cam, const int viewport[4], int rect[4]) const
+{
+    for(int i=0; i<4; i++)
+        rect[i] = viewport[i];
+    if(!bounded())
+        return true;
+
+    const QMatrix4x4 P = cam.projectionMatrix();
+    const QVector3D c = cam.viewMatrix() * center_;
+
+    // completely behind the camera?
+    const float zNear = P(2,3) / (P(2,2) - 1.0f);
+    if(c.z() - range_ > -zNear)
+        return false;
+
+    // reaching the near plane: corners might be behind the camera, keep the whole viewport
+    if(c.z() + range_ > -zNear)
+        return true;
+
+    // project the corners of the sphere's view-space bounding box
+    float x0 = 1, y0 = 1, x1 = -1, y1 = -1;
+    for(int k=0; k<8; k++) {
+        QVector3D corner = c + range_ * QVector3D(k & 1? 1 : -1, k & 2? 1 : -1, k & 4? 1 : -1);
+        QVector3D ndc = P * corner;
+        x0 = min(x0, ndc.x()); x1 = max(x1, ndc.x());
+        y0 = min(y0, ndc.y()); y1 = max(y1, ndc.y());
+    }
+    x0 = max(x0, -1.0f); y0 = max(y0, -1.0f);
+    x1 = min(x1,  1.0f); y1 = min(y1,  1.0f);
+    if(x0 >= x1 || y0 >= y1)
+        return false;
+
+    // NDC to window coordinates, rounded outwards
+    int left   = viewport[0] + int(floor((x0 * 0.5f + 0.5f) * viewport[2]));
+    int bottom = viewport[1] + int(floor((y0 * 0.5f + 0.5f) * viewport[3]));
+    int right  = viewport[0] + int(ceil((x1 * 0.5f + 0.5f) * viewport[2]));
+    int top    = viewport[1] + int(ceil((y1 * 0.5f + 0.5f) * viewport[3]));
+    rect[0] = left;
+    rect[1] = bottom;
+    rect[2] = right - left;
+    rect[3] = top - bottom;
+    return true;
+}
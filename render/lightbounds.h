@@ -0,0 +1,43 @@
+#pragma once
+
+#include "camera.h"
+
+#include <QVector3D>
+#include <QMatrix4x4>
+
+class BoundingBox;
+
+/*
+ *  Region a point light with a limited range can reach: a sphere
+ *  around the light. Used to restrict a light pass to the meshes
+ *  touching the sphere (see DrawList::submit()) and to the screen
+ *  rectangle covered by it (glScissor). Unbounded lights reach
+ *  everything.
+ *
+ */
+class LightBounds
+{
+public:
+
+    // sphere in world coordinates; range <= 0: unbounded
+    LightBounds(const QVector3D& position_WC, float range);
+
+    bool bounded() const { return range_ > 0; }
+
+    // does a model-space bounding box, transformed by modelMatrix, touch the sphere?
+    bool intersects(const BoundingBox& bbox, const QMatrix4x4& modelMatrix) const;
+
+    /*
+     *  Window rectangle (x, y, width, height, as for glScissor) covering
+     *  the sphere in the given viewport. Returns false if the sphere is
+     *  completely off screen, i.e. the pass can be skipped. The whole
+     *  viewport is returned for unbounded lights and for spheres reaching
+     *  the near plane. Assumes a perspective projection.
+     */
+    bool scissorRect(const Camera& cam, const int viewport[4], int rect[4]) const;
+
+protected:
+
+    QVector3D center_;
+    float range_;
+};
@@ -0,0 +1,254 @@
+#include "render/lightclusters.h"
+#include "render/glfunctions.h"
+#include "render/renderstats.h"
+#include "render/textureunits.h"
+#include "jobs/jobsystem.h"
+
+#include <algorithm> // std::min, std::max
+#include <chrono>    // std::chrono::steady_clock
+#include <cmath>     // std::pow, std::log
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define LIGHTCLUSTERS_SSE2
+#include <emmintrin.h> // SSE2 intrinsics
+#endif
+
+using namespace std;
+
+namespace {
+
+// stands in for the range of unbounded lights; its square is still a finite float
+const float unbounded = 1e18f;
+
+enum { LightData = 0, Grid = 1, Indices = 2 };
+
+}
+
+LightClusters::LightClusters()
+    : slices_(slices)
+{
+    auto& gl = glCore();
+    gl.glGenBuffers(3, buffers_);
+    gl.glGenTextures(3, textures_);
+
+    // attach each buffer to its texture once; orphaning keeps the buffer name.
+    // this binds behind TextureUnits' back, so it has to forget its bindings.
+    const GLenum formats[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+    for(int i=0; i<3; i++) {
+        gl.glBindBuffer(GL_TEXTURE_BUFFER, buffers_[i]);
+        gl.glBufferData(GL_TEXTURE_BUFFER, 16, nullptr, GL_STREAM_DRAW);
+        gl.glBindTexture(GL_TEXTURE_BUFFER, textures_[i]);
+        gl.glTexBuffer(GL_TEXTURE_BUFFER, formats[i], buffers_[i]);
+    }
+    gl.glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    gl.glBindTexture(GL_TEXTURE_BUFFER, 0);
+    TextureUnits::current().invalidate();
+
+    for(auto& s : slices_)
+        s.counts.resize(tilesX * tilesY);
+}
+
+LightClusters::~LightClusters()
+{
+    if(!QOpenGLContext::currentContext())
+        return;
+    auto& gl = glCore();
+    gl.glDeleteTextures(3, textures_);
+    gl.glDeleteBuffers(3, buffers_);
+}
+
+float LightClusters::sliceDepth(int s) const
+{
+    if(s <= 0)
+        return zNear_;
+    if(s >= slices)
+        return zFar_;
+    return sliceNear * pow(sliceFar / sliceNear, float(s) / slices);
+}
+
+void LightClusters::updateBounds(const QMatrix4x4 &projection)
+{
+    if(!bounds_.empty() && projection == projection_)
+        return;
+    projection_ = projection;
+
+    // near and far plane of the perspective projection
+    zNear_ = projection(2,3) / (projection(2,2) - 1.0f);
+    zFar_  = projection(2,3) / (projection(2,2) + 1.0f);
+
+    // x_EC = x_NDC * depth / P(0,0), same for y
+    const float sx = 1.0f / projection(0,0), sy = 1.0f / projection(1,1);
+
+    bounds_.resize(size_t(slices) * tilesX * tilesY);
+    for(int s=0; s<slices; s++) {
+        const float d0 = sliceDepth(s), d1 = sliceDepth(s + 1);
+        for(int ty=0; ty<tilesY; ty++) {
+            const float y0 = -1.0f + 2.0f * ty / tilesY, y1 = -1.0f + 2.0f * (ty + 1) / tilesY;
+            for(int tx=0; tx<tilesX; tx++) {
+                const float x0 = -1.0f + 2.0f * tx / tilesX, x1 = -1.0f + 2.0f * (tx + 1) / tilesX;
+
+                // the tile's frustum between both depths: extremes are at its corners
+                Box& b = bounds_[(size_t(s) * tilesY + ty) * tilesX + tx];
+                b.min[0] = min(min(x0 * d0, x0 * d1), min(x1 * d0, x1 * d1)) * sx;
+                b.max[0] = max(max(x0 * d0, x0 * d1), max(x1 * d0, x1 * d1)) * sx;
+                b.min[1] = min(min(y0 * d0, y0 * d1), min(y1 * d0, y1 * d1)) * sy;
+                b.max[1] = max(max(y0 * d0, y0 * d1), max(y1 * d0, y1 * d1)) * sy;
+                b.min[2] = -d1;
+                b.max[2] = -d0;
+            }
+        }
+    }
+}
+
+void LightClusters::binSlice(int s, size_t n)
+{
+    Slice& slice = slices_[s];
+    slice.candidates.clear();
+    slice.indices.clear();
+
+    // lights overlapping the slice's depth range
+    const float zMin = -sliceDepth(s + 1), zMax = -sliceDepth(s);
+    for(size_t i=0; i<n; i++) {
+        if(z_[i] - r_[i] <= zMax && z_[i] + r_[i] >= zMin)
+            slice.candidates.push_back(uint32_t(i));
+    }
+
+    // copy them into contiguous arrays, padded to a multiple of four with
+    // spheres that touch nothing (negative squared radius)
+    const size_t m = slice.candidates.size();
+    const size_t padded = (m + 3) & ~size_t(3);
+    slice.x.assign(padded, 0.0f);
+    slice.y.assign(padded, 0.0f);
+    slice.z.assign(padded, 0.0f);
+    slice.r2.assign(padded, -1.0f);
+    for(size_t k=0; k<m; k++) {
+        uint32_t i = slice.candidates[k];
+        slice.x[k] = x_[i]; slice.y[k] = y_[i]; slice.z[k] = z_[i];
+        slice.r2[k] = r_[i] * r_[i];
+    }
+
+    // sphere / box test per tile: a hit mask for all candidates, then compaction
+    const Box* boxes = &bounds_[size_t(s) * tilesX * tilesY];
+    for(int t=0; t<tilesX * tilesY; t++) {
+        const Box& b = boxes[t];
+        size_t begin = slice.indices.size();
+#ifdef LIGHTCLUSTERS_SSE2
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 minX = _mm_set1_ps(b.min[0]), maxX = _mm_set1_ps(b.max[0]);
+        const __m128 minY = _mm_set1_ps(b.min[1]), maxY = _mm_set1_ps(b.max[1]);
+        const __m128 minZ = _mm_set1_ps(b.min[2]), maxZ = _mm_set1_ps(b.max[2]);
+        for(size_t k=0; k<padded; k+=4) {
+            __m128 x = _mm_loadu_ps(&slice.x[k]);
+            __m128 y = _mm_loadu_ps(&slice.y[k]);
+            __m128 z = _mm_loadu_ps(&slice.z[k]);
+            __m128 dx = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minX, x), _mm_sub_ps(x, maxX)), zero);
+            __m128 dy = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minY, y), _mm_sub_ps(y, maxY)), zero);
+            __m128 dz = _mm_max_ps(_mm_max_ps(_mm_sub_ps(minZ, z), _mm_sub_ps(z, maxZ)), zero);
+            __m128 d2 = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)),
+                                   _mm_mul_ps(dz, dz));
+            int mask = _mm_movemask_ps(_mm_cmple_ps(d2, _mm_loadu_ps(&slice.r2[k])));
+            for(int j=0; mask != 0; j++, mask >>= 1) {
+                if(mask & 1)
+                    slice.indices.push_back(uint16_t(slice.candidates[k + j]));
+            }
+        }
+#else
+        slice.hits.resize(padded);
+        for(size_t k=0; k<padded; k++) {
+            float dx = max(max(b.min[0] - slice.x[k], slice.x[k] - b.max[0]), 0.0f);
+            float dy = max(max(b.min[1] - slice.y[k], slice.y[k] - b.max[1]), 0.0f);
+            float dz = max(max(b.min[2] - slice.z[k], slice.z[k] - b.max[2]), 0.0f);
+            slice.hits[k] = uint8_t(dx*dx + dy*dy + dz*dz <= slice.r2[k]);
+        }
+        for(size_t k=0; k<m; k++) {
+            if(slice.hits[k])
+                slice.indices.push_back(uint16_t(slice.candidates[k]));
+        }
+#endif
+        slice.counts[t] = uint32_t(slice.indices.size() - begin);
+    }
+}
+
+void LightClusters::update(const Camera &cam)
+{
+    auto start = chrono::steady_clock::now();
+    auto& gl = glCore();
+
+    GLint viewport[4];
+    gl.glGetIntegerv(GL_VIEWPORT, viewport);
+    viewportWidth_ = float(max(viewport[2], 1));
+    viewportHeight_ = float(max(viewport[3], 1));
+
+    updateBounds(cam.projectionMatrix());
+
+    // light spheres in view space
+    const size_t n = min(lights.size(), size_t(maxLights));
+    x_.resize(n); y_.resize(n); z_.resize(n); r_.resize(n);
+    vector<float> lightData(max(n, size_t(1)) * 8, 0.0f);
+    for(size_t i=0; i<n; i++) {
+        const Light& light = lights[i];
+        QVector3D c = cam.viewMatrix() * light.position_WC;
+        x_[i] = c.x(); y_[i] = c.y(); z_[i] = c.z();
+        r_[i] = light.range > 0? light.range : unbounded;
+
+        float* d = &lightData[8*i];
+        for(int k=0; k<3; k++) {
+            d[k]   = light.position_WC[k];
+            d[4+k] = light.intensity[k];
+        }
+        d[3] = light.range;
+    }
+
+    // bin the lights, one depth slice per job
+    JobSystem::instance().parallelFor(0, slices, 1, [this, n](size_t from, size_t to) {
+        for(size_t s=from; s<to; s++)
+            binSlice(int(s), n);
+    });
+
+    // merge the slices: (first index, count) per cluster, and one index list
+    vector<uint32_t> grid(size_t(slices) * tilesX * tilesY * 2);
+    vector<uint16_t> indices;
+    size_t cluster = 0;
+    for(const auto& slice : slices_) {
+        size_t offset = indices.size();
+        for(uint32_t count : slice.counts) {
+            grid[2*cluster]   = uint32_t(offset);
+            grid[2*cluster+1] = count;
+            offset += count;
+            cluster++;
+        }
+        indices.insert(indices.end(), slice.indices.begin(), slice.indices.end());
+    }
+    if(indices.empty())
+        indices.push_back(0);
+
+    // upload, orphaning the old storage; the textures see the new storage
+    auto upload = [&gl, this](int which, const void* data, size_t bytes) {
+        gl.glBindBuffer(GL_TEXTURE_BUFFER, buffers_[which]);
+        gl.glBufferData(GL_TEXTURE_BUFFER, GLsizeiptr(bytes), nullptr, GL_STREAM_DRAW);
+        gl.glBufferSubData(GL_TEXTURE_BUFFER, 0, GLsizeiptr(bytes), data);
+    };
+    upload(LightData, lightData.data(), lightData.size() * sizeof(float));
+    upload(Grid, grid.data(), grid.size() * sizeof(uint32_t));
+    upload(Indices, indices.data(), indices.size() * sizeof(uint16_t));
+    gl.glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    auto& stats = RenderStats::current();
+    stats.clusterLights += n;
+    stats.clusterLightRefs += indices.size();
+    stats.clusterMilliseconds +=
+            chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+void LightClusters::apply(UniformCache &uniforms) const
+{
+    auto& units = TextureUnits::current();
+    const auto sampler = TextureUnits::Sampler::Screen; // ignored by buffer textures
+    uniforms.set("clusterLights", units.bind(GL_TEXTURE_BUFFER, textures_[LightData], sampler));
+    uniforms.set("clusterGrid", units.bind(GL_TEXTURE_BUFFER, textures_[Grid], sampler));
+    uniforms.set("clusterLightIndices", units.bind(GL_TEXTURE_BUFFER, textures_[Indices], sampler));
+
+    uniforms.set("clusterParams", QVector4D(viewportWidth_ / tilesX, viewportHeight_ / tilesY,
+                                            sliceNear, slices / log(sliceFar / sliceNear)));
+    uniforms.set("clusterCount", QVector3D(tilesX, tilesY, slices));
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "camera.h"
+#include "render/uniformcache.h"
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include <cstdint> // uint16_t, uint32_t
+#include <vector>  // std::vector
+
+/*
+ *  Clustered light culling: the view frustum is divided into a grid of
+ *  clusters (screen tiles x exponential depth slices), and each light
+ *  with a limited range is binned into the clusters its sphere touches.
+ *  The fragment shader then only loops over the lights of its cluster,
+ *  so hundreds of small lights cost about as much per pixel as the few
+ *  that actually reach it.
+ *
+ *  Binning runs on the CPU every frame, one depth slice per job on the
+ *  JobSystem. Each slice copies the lights in its depth range into
+ *  contiguous arrays and tests them against a tile four at a time with
+ *  SSE2 (a branch-free scalar loop elsewhere), then compacts the hits.
+ *  Results are uploaded into buffer textures (GLSL side, see the
+ *  CLUSTERED_LIGHTS variant of textured_phong.frag):
+ *
+ *      uniform samplerBuffer  clusterLights;       // per light: position_WC + range, intensity
+ *      uniform usamplerBuffer clusterGrid;         // per cluster: first index, number of lights
+ *      uniform usamplerBuffer clusterLightIndices; // light indices of all clusters
+ *      uniform vec4 clusterParams;  // tile size in pixels (xy), near depth, slices / log(far / near)
+ *      uniform vec3 clusterCount;   // tiles x, tiles y, slices
+ *
+ *  The projection is assumed to be a symmetric perspective projection.
+ *
+ */
+class LightClusters
+{
+public:
+
+    // grid resolution
+    static const int tilesX = 16;
+    static const int tilesY = 8;
+    static const int slices = 24;
+
+    // lights are referenced by 16 bit indices
+    static const size_t maxLights = 65535;
+
+    struct Light {
+        QVector3D position_WC;
+        float range = 0;          // contribution fades to zero at this distance; <= 0: unbounded
+        QVector3D intensity;      // color * intensity
+    };
+
+    // all lights of the current frame, set by the scene
+    std::vector<Light> lights;
+
+    // depth range that is sliced exponentially; nearer and farther
+    // fragments go into the first and last slice
+    float sliceNear = 0.1f;
+    float sliceFar = 100.0f;
+
+    LightClusters();
+    ~LightClusters();
+
+    // bin the lights for the camera and the current viewport, then upload (GL thread)
+    void update(const Camera& cam);
+
+    // bind the buffer textures and set the cluster uniforms of a program (during apply())
+    void apply(UniformCache& uniforms) const;
+
+    // do not copy, owns OpenGL buffers
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+protected:
+
+    // view-space bounding box of a cluster
+    struct Box {
+        float min[3], max[3];
+    };
+
+    // per depth slice binning results, written by one job
+    struct Slice {
+        std::vector<uint32_t> candidates;  // lights overlapping the slice's depth range
+        std::vector<float> x, y, z, r2;    // their spheres, padded to a multiple of 4
+        std::vector<uint8_t> hits;         // per candidate hit mask (without SSE2)
+        std::vector<uint16_t> indices;     // light indices, tile by tile
+        std::vector<uint32_t> counts;      // number of lights per tile
+    };
+
+    // recompute the cluster boxes if the projection has changed
+    void updateBounds(const QMatrix4x4& projection);
+
+    // bin the first n lights into the tiles of slice s
+    void binSlice(int s, size_t n);
+
+    // depth (distance along -z) where slice s starts
+    float sliceDepth(int s) const;
+
+    // cluster boxes, slice by slice, and the projection they were made for
+    std::vector<Box> bounds_;
+    QMatrix4x4 projection_;
+    float zNear_ = 0, zFar_ = 0;
+
+    // view-space light spheres, structure of arrays
+    std::vector<float> x_, y_, z_, r_;
+
+    std::vector<Slice> slices_;
+
+    // viewport size in pixels, from the last update()
+    float viewportWidth_ = 1, viewportHeight_ = 1;
+
+    // buffer objects and their buffer textures: lights, grid, indices
+    GLuint buffers_[3] = {0,0,0};
+    GLuint textures_[3] = {0,0,0};
+
+};
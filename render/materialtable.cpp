@@ -0,0 +1,77 @@
+#include "render/materialtable.h"
+#include "render/glfunctions.h"
+#include "render/renderstats.h"
+#include "material/phong.h"
+
+#include <cstring> // std::memcmp
+
+using namespace std;
+
+MaterialTable::MaterialTable()
+{
+    auto& gl = glCore();
+    gl.glGenBuffers(1, &ubo_);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+    gl.glBufferData(GL_UNIFORM_BUFFER, maxMaterials * sizeof(Record), nullptr, GL_DYNAMIC_DRAW);
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+}
+
+MaterialTable::~MaterialTable()
+{
+    if(ubo_ && QOpenGLContext::currentContext())
+        glCore().glDeleteBuffers(1, &ubo_);
+}
+
+void MaterialTable::add(shared_ptr<PhongMaterial> material)
+{
+    if(materials_.size() >= size_t(maxMaterials))
+        qFatal("MaterialTable: too many materials");
+
+    material->materialIndex = int(materials_.size());
+    materials_.push_back(material);
+}
+
+void MaterialTable::update()
+{
+    auto& gl = glCore();
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, ubo_);
+
+    // new materials have never been uploaded
+    size_t known = shadow_.size();
+    shadow_.resize(materials_.size());
+
+    // upload changed records; neighbouring changes are combined into one upload
+    size_t first = 0, count = 0;
+    auto flush = [&] {
+        if(count)
+            gl.glBufferSubData(GL_UNIFORM_BUFFER, GLintptr(first * sizeof(Record)),
+                               GLsizeiptr(count * sizeof(Record)), &shadow_[first]);
+        RenderStats::current().materialUploads += count;
+        count = 0;
+    };
+
+    for(size_t i=0; i<materials_.size(); i++) {
+        Record r = {};
+        materials_[i]->pack(r);
+        if(i < known && memcmp(&r, &shadow_[i], sizeof(Record)) == 0) {
+            flush();
+            continue;
+        }
+        shadow_[i] = r;
+        if(!count)
+            first = i;
+        count++;
+    }
+    flush();
+
+    gl.glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    gl.glBindBufferBase(GL_UNIFORM_BUFFER, bindingPoint, ubo_);
+}
+
+void MaterialTable::bindProgram(QOpenGLShaderProgram &prog)
+{
+    auto& gl = glCore();
+    GLuint index = gl.glGetUniformBlockIndex(prog.programId(), "MaterialData");
+    if(index != GL_INVALID_INDEX)
+        gl.glUniformBlockBinding(prog.programId(), index, bindingPoint);
+}
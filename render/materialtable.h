@@ -0,0 +1,89 @@
+#pragma once
+
+#include <QOpenGLShaderProgram>
+
+#include <memory>  // std::shared_ptr
+#include <vector>  // std::vector
+#include <cstdint> // int32_t
+
+class PhongMaterial;
+
+/*
+ *  Parameters of all Phong-type materials, packed into one fixed-size
+ *  record per material and kept in a uniform buffer. A draw selects
+ *  its record with a single integer uniform (materialIndex), instead
+ *  of setting all material uniforms by name.
+ *
+ *  update() packs every registered material once per frame and
+ *  compares the result with a shadow copy of the buffer contents;
+ *  only records that actually changed (e.g. by Scene::setDiffuseScale())
+ *  are uploaded.
+ *
+ *  GLSL side (std140 layout):
+ *
+ *      struct MaterialRecord {
+ *          vec4  k_ambient;     // w: unused
+ *          vec4  k_diffuse;     // w: unused
+ *          vec4  k_specular;    // w: shininess
+ *          vec4  k_mirror;      // w: refract_ratio
+ *          vec4  k_refract;     // w: emissive_scale
+ *          ivec4 textures;      // use diffuse, emissive, gloss, environment
+ *          ivec4 mapping;       // bump use, bump debug, displacement use, unused
+ *          vec4  scales;        // bump scale, displacement scale, unused, unused
+ *      };
+ *      layout(std140) uniform MaterialData {
+ *          MaterialRecord materials[64];
+ *      };
+ *
+ *  Textures are not part of the record, they are bound by the material.
+ *
+ */
+class MaterialTable
+{
+public:
+
+    // binding point of the MaterialData block, in all programs
+    static const unsigned int bindingPoint = 2;
+
+    // size of the materials array in the shaders
+    static const int maxMaterials = 64;
+
+    // one material, std140 layout
+    struct Record {
+        float k_ambient[4];
+        float k_diffuse[4];
+        float k_specular[4];
+        float k_mirror[4];
+        float k_refract[4];
+        int32_t textures[4];
+        int32_t mapping[4];
+        float scales[4];
+    };
+    static_assert(sizeof(Record) == 128, "MaterialRecord does not match std140 layout");
+
+    MaterialTable();
+    ~MaterialTable();
+
+    // add a material and assign its materialIndex
+    void add(std::shared_ptr<PhongMaterial> material);
+
+    // upload the records of materials that changed since the last call, and bind the buffer
+    void update();
+
+    // connect the program's MaterialData block (if any) to the binding point
+    static void bindProgram(QOpenGLShaderProgram& prog);
+
+    // do not copy, owns an OpenGL buffer
+    MaterialTable(const MaterialTable&) = delete;
+    MaterialTable& operator=(const MaterialTable&) = delete;
+
+protected:
+
+    std::vector<std::shared_ptr<PhongMaterial>> materials_;
+
+    // what the buffer currently contains
+    std::vector<Record> shadow_;
+
+    unsigned int ubo_ = 0;
+};
+
@@ -0,0 +1,159 @@
+#include "render/occlusionquery.h"
+#include "render/glfunctions.h"
+#include "render/renderstats.h"
+#include "render/glstate.h"
+
+#include <assert.h>
+#include <cmath> // std::fabs
+
+OcclusionQuery::OcclusionQuery(std::shared_ptr<Mesh> proxy)
+    : proxy_(proxy)
+{
+    if(!proxy_)
+        qFatal("OcclusionQuery: need a proxy mesh");
+}
+
+OcclusionQuery::~OcclusionQuery()
+{
+    // only delete the query if the context still exists
+    if(id_ && QOpenGLContext::currentContext())
+        glCore().glDeleteQueries(1, &id_);
+}
+
+void OcclusionQuery::pollResult()
+{
+    if(!pending_)
+        return;
+
+    auto& gl = glCore();
+
+    // never wait for the GPU: only read the result once it is there
+    GLuint available = 0;
+    gl.glGetQueryObjectuiv(id_, GL_QUERY_RESULT_AVAILABLE, &available);
+    if(!available)
+        return;
+
+    GLuint samples = 0;
+    gl.glGetQueryObjectuiv(id_, GL_QUERY_RESULT, &samples);
+    visible_ = samples > 0;
+    pending_ = false;
+}
+
+bool OcclusionQuery::begin(const Camera &cam, const QMatrix4x4 &modelMatrix,
+                           const BoundingBox &bbox, unsigned int light_pass)
+{
+    assert(active_ == Active::Nothing);
+
+    auto& gl = glCore();
+    auto& stats = RenderStats::current();
+
+    if(!id_)
+        gl.glGenQueries(1, &id_);
+
+    pollResult();
+
+    // if the camera is inside the box, the box would be clipped by the near
+    // plane and report zero samples: always treat the node as visible then.
+    // test in world space, against the box around the transformed (slightly grown) box
+    QVector3D eye = cam.position_WC();
+    QVector3D center = modelMatrix * bbox.center();
+    QVector3D r = bbox.radii() * 1.05f + QVector3D(0.01f,0.01f,0.01f);
+    bool inside = true;
+    for(int i=0; i<3 && inside; i++) {
+        float extent = std::fabs(modelMatrix(i,0)) * r.x() +
+                       std::fabs(modelMatrix(i,1)) * r.y() +
+                       std::fabs(modelMatrix(i,2)) * r.z();
+        inside = std::fabs(eye[i] - center[i]) < extent;
+    }
+    if(inside) {
+        visible_ = true;
+        return true;
+    }
+
+    // issue a new query, but only if the previous one has been read back
+    if((light_pass == 0 || light_pass == Material::allLights) && !pending_) {
+
+        stats.occlusionQueries++;
+
+        if(visible_) {
+            // visible node: the actual draw tells whether it is still visible
+            gl.glBeginQuery(GL_SAMPLES_PASSED, id_);
+            active_ = Active::Query;
+            return true;
+        }
+
+        // hidden node: test the bounding box, then draw depending on its result
+        gl.glBeginQuery(GL_SAMPLES_PASSED, id_);
+        drawProxy(cam, modelMatrix, bbox);
+        gl.glEndQuery(GL_SAMPLES_PASSED);
+        pending_ = true;
+    }
+
+    if(visible_)
+        return true;
+
+    // hidden, and the result of the most recent query is already known
+    if(!pending_) {
+        stats.occlusionCulled++;
+        return false;
+    }
+
+    // hidden as of last known result: let the GPU decide, without waiting
+    // for the query. If the result is not there yet, the node is drawn.
+    gl.glBeginConditionalRender(id_, GL_QUERY_NO_WAIT);
+    stats.occlusionConditional++;
+    active_ = Active::ConditionalRender;
+    return true;
+}
+
+void OcclusionQuery::end()
+{
+    auto& gl = glCore();
+
+    switch(active_) {
+    case Active::Query:
+        gl.glEndQuery(GL_SAMPLES_PASSED);
+        pending_ = true;
+        break;
+    case Active::ConditionalRender:
+        gl.glEndConditionalRender();
+        break;
+    case Active::Nothing:
+        break;
+    }
+    active_ = Active::Nothing;
+}
+
+void OcclusionQuery::drawProxy(const Camera &cam, const QMatrix4x4 &modelMatrix, const BoundingBox &bbox)
+{
+    auto& gl = glCore();
+    auto& state = GLState::current();
+
+    // unit cube -> bounding box of the node's mesh
+    QMatrix4x4 boxMatrix = modelMatrix;
+    boxMatrix.translate(bbox.center());
+    boxMatrix.scale(bbox.radii() * 2.0f);
+
+    // the box must be rasterized even if seen from inside or from the back,
+    // and it must not leave any traces in the color or depth buffer.
+    // light passes after a depth pre-pass test with GL_EQUAL, the box needs GL_LESS.
+    GLboolean depthMask, colorMask[4];
+    GLint depthFunc;
+    bool cullFace = state.isEnabled(GL_CULL_FACE);
+    gl.glGetBooleanv(GL_DEPTH_WRITEMASK, &depthMask);
+    gl.glGetBooleanv(GL_COLOR_WRITEMASK, colorMask);
+    gl.glGetIntegerv(GL_DEPTH_FUNC, &depthFunc);
+    gl.glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+    gl.glDepthMask(GL_FALSE);
+    state.disable(GL_CULL_FACE);
+    state.depthFunc(GL_LESS);
+
+    cam.setShaderTransformationMatrices(*proxy_->material(), boxMatrix);
+    proxy_->draw();
+    RenderStats::current().occlusionProxies++;
+
+    gl.glColorMask(colorMask[0], colorMask[1], colorMask[2], colorMask[3]);
+    gl.glDepthMask(depthMask);
+    state.set(GL_CULL_FACE, cullFace);
+    state.depthFunc(GLenum(depthFunc));
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "mesh/mesh.h"
+#include "mesh/bbox.h"
+#include "camera.h"
+
+#include <QMatrix4x4>
+#include <memory> // std::shared_ptr
+
+/*
+ *  Hardware occlusion query for a single node.
+ *
+ *  Before the node's mesh is drawn, begin() decides how to draw it,
+ *  reusing query results across frames in the style of coherent
+ *  hierarchical culling (CHC), so the CPU never waits for the GPU:
+ *
+ *  - a query result is only read back once it is available; until
+ *    then the last known visibility is used.
+ *  - nodes known to be visible are drawn normally, and the draw
+ *    itself is wrapped into the next query.
+ *  - nodes known to be hidden only get their bounding box drawn
+ *    into a query (no color, no depth writes), and the actual draw
+ *    uses conditional rendering on that query.
+ *
+ *  New queries are only issued in light pass 0 (or the single pass
+ *  shading all lights, see Material::allLights). Later light passes
+ *  use conditional rendering on the most recent query, or skip the
+ *  draw entirely if the node is known to be hidden.
+ *
+ *  Usage (see Node::draw()):
+ *      if(query.begin(cam, model, bbox, light_pass)) {
+ *          ... draw mesh ...
+ *          query.end();
+ *      }
+ *
+ */
+class OcclusionQuery
+{
+public:
+
+    // proxy: unit cube mesh (-0.5 ... 0.5) used to draw the bounding box
+    OcclusionQuery(std::shared_ptr<Mesh> proxy);
+    ~OcclusionQuery();
+
+    // returns false if the draw can be skipped; if true, end() must follow the draw
+    bool begin(const Camera& cam, const QMatrix4x4& modelMatrix,
+               const BoundingBox& bbox, unsigned int light_pass);
+
+    // end query / conditional rendering started in begin()
+    void end();
+
+    // last known visibility
+    bool isVisible() const { return visible_; }
+
+    // do not copy queries, they own an OpenGL query object
+    OcclusionQuery(const OcclusionQuery&) = delete;
+    OcclusionQuery& operator=(const OcclusionQuery&) = delete;
+
+protected:
+
+    // read back result of the pending query, if it is available
+    void pollResult();
+
+    // draw the bounding box into the query, without touching color or depth
+    void drawProxy(const Camera& cam, const QMatrix4x4& modelMatrix, const BoundingBox& bbox);
+
+    // cube mesh used as bounding box proxy
+    std::shared_ptr<Mesh> proxy_;
+
+    // OpenGL query object
+    unsigned int id_ = 0;
+
+    // query has been issued, but its result has not been read back yet
+    bool pending_ = false;
+
+    // last known result: did any sample pass?
+    bool visible_ = true;
+
+    // what has been started in begin() and needs to be closed in end()
+    enum class Active { Nothing, Query, ConditionalRender } active_ = Active::Nothing;
+};
+
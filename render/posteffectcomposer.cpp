@@ -0,0 +1,73 @@
+#include "render/posteffectcomposer.h"
+
+#include <QFile>
+
+#include <algorithm> // std::find
+#include <sstream>   // std::ostringstream
+
+using namespace std;
+
+void PostEffectComposer::addEffect(const string &name, Kind kind, const string &filename)
+{
+    QFile file(filename.c_str());
+    if(!file.open(QIODevice::ReadOnly))
+        qFatal("PostEffectComposer: cannot read effect snippet");
+    effects_[name] = { kind, file.readAll().toStdString() };
+}
+
+size_t PostEffectComposer::groupLength(const vector<string> &chain, size_t begin) const
+{
+    bool neighborhood = false;
+    size_t end = begin;
+    for(; end < chain.size(); end++) {
+        auto e = effects_.find(chain[end]);
+        if(e == effects_.end())
+            break;
+
+        // a second neighborhood effect would multiply the taps, an effect twice its function
+        if(e->second.kind == Kind::Neighborhood && neighborhood)
+            break;
+        if(find(chain.begin() + begin, chain.begin() + end, chain[end]) != chain.begin() + end)
+            break;
+        neighborhood = neighborhood || e->second.kind == Kind::Neighborhood;
+    }
+    return end - begin;
+}
+
+string PostEffectComposer::fragmentSource(const vector<string> &group) const
+{
+    ostringstream s;
+    s << "#version 150\n"
+         "// generated by PostEffectComposer: " << key(group) << "\n"
+         "uniform sampler2D post_tex;\n"
+         "uniform int image_width;\n"
+         "uniform int image_height;\n"
+         "in vec2 texcoord_frag;\n"
+         "out vec4 outColor;\n"
+         "#define TEXEL (1.0 / vec2(image_width, image_height))\n"
+         "vec3 stage0(vec2 uv) { return texture(post_tex, uv).rgb; }\n";
+
+    for(size_t i=0; i<group.size(); i++) {
+        const auto& name = group[i];
+        const auto& effect = effects_.at(name);
+        s << "#define SOURCE stage" << i << "\n"
+          << effect.glsl << "\n"
+          << "#undef SOURCE\n"
+          << "vec3 stage" << i+1 << "(vec2 uv) { return ";
+        if(effect.kind == Kind::Pointwise)
+            s << name << "(stage" << i << "(uv), uv); }\n";
+        else
+            s << name << "(uv); }\n";
+    }
+
+    s << "void main(void) { outColor = vec4(stage" << group.size() << "(texcoord_frag), 1); }\n";
+    return s.str();
+}
+
+string PostEffectComposer::key(const vector<string> &group)
+{
+    string k;
+    for(const auto& name : group)
+        k += (k.empty()? "" : "+") + name;
+    return k;
+}
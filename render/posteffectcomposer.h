@@ -0,0 +1,57 @@
+#pragma once
+
+#include <map>    // std::map
+#include <string> // std::string
+#include <vector> // std::vector
+
+/*
+ *  Fuses chains of simple post processing effects into one pass.
+ *
+ *  Each effect is a GLSL snippet defining one function named like the
+ *  effect:
+ *   - pointwise effects (color transforms, tone curves, vignettes ...)
+ *     map a color:  vec3 name(vec3 color, vec2 uv)
+ *   - neighborhood effects read a few fixed taps around the pixel
+ *     through SOURCE(uv), TEXEL being the size of a texel:
+ *                   vec3 name(vec2 uv)
+ *
+ *  fragmentSource() chains the snippets of a group into the fragment
+ *  shader of a single pass: each stage evaluates the previous one, so
+ *  a neighborhood effect after pointwise effects applies them to each
+ *  of its taps instead of reading an intermediate image. To keep this
+ *  cheap, a group holds at most one neighborhood effect, and an effect
+ *  only once (see groupLength()).
+ *
+ *  The composer only generates source code; compiling and caching the
+ *  programs per group is up to the caller (see Scene::addFusedEffects_()).
+ *
+ */
+class PostEffectComposer
+{
+public:
+
+    enum class Kind { Pointwise, Neighborhood };
+
+    // register an effect, its snippet is read from a file (or resource)
+    void addEffect(const std::string& name, Kind kind, const std::string& filename);
+
+    // can the effect be fused at all?
+    bool fusable(const std::string& name) const { return effects_.count(name) > 0; }
+
+    // number of effects from chain[begin] on that fuse into one pass (0: not fusable)
+    size_t groupLength(const std::vector<std::string>& chain, size_t begin) const;
+
+    // fragment shader of a pass running all effects of the group in order
+    std::string fragmentSource(const std::vector<std::string>& group) const;
+
+    // name of a group, e.g. for caching its program
+    static std::string key(const std::vector<std::string>& group);
+
+protected:
+
+    struct Effect {
+        Kind kind;
+        std::string glsl;
+    };
+    std::map<std::string, Effect> effects_;
+};
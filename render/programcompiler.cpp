@@ -0,0 +1,134 @@
+#include "render/programcompiler.h"
+#include "render/glfunctions.h"
+
+#include <QThread>
+#include <QDebug>
+
+using namespace std;
+
+ProgramCompiler::ProgramCompiler(QOpenGLContext *context)
+    : shareContext_(context), glThread_(QThread::currentThread())
+{
+    if(!QOpenGLContext::supportsThreadedOpenGL())
+        return;
+
+    // surfaces must be created on the GUI thread
+    surface_ = make_unique<QOffscreenSurface>();
+    surface_->setFormat(context->format());
+    surface_->create();
+    if(!surface_->isValid()) {
+        surface_.reset();
+        return;
+    }
+
+    threaded_ = true;
+    worker_ = thread(&ProgramCompiler::workerLoop, this);
+}
+
+ProgramCompiler::~ProgramCompiler()
+{
+    {
+        lock_guard<mutex> lock(mutex_);
+        running_ = false;
+        queue_.clear();
+    }
+    wakeUp_.notify_all();
+
+    if(worker_.joinable())
+        worker_.join();
+}
+
+shared_ptr<ProgramCompiler::Request> ProgramCompiler::submit(Build build, Ready ready)
+{
+    auto request = make_shared<Request>();
+    request->build_ = move(build);
+    request->ready_ = move(ready);
+
+    {
+        lock_guard<mutex> lock(mutex_);
+        queue_.push_back(request);
+    }
+    wakeUp_.notify_one();
+
+    pending_.push_back(request);
+    return request;
+}
+
+size_t ProgramCompiler::poll()
+{
+    // no worker: build one program per call on this thread
+    if(!threaded()) {
+        shared_ptr<Request> request;
+        {
+            lock_guard<mutex> lock(mutex_);
+            if(!queue_.empty()) {
+                request = queue_.front();
+                queue_.pop_front();
+            }
+        }
+        if(request)
+            build(*request);
+    }
+
+    // deliver finished programs
+    for(size_t i=0; i<pending_.size(); ) {
+        auto& request = *pending_[i];
+        if(!request.isDone()) {
+            i++;
+            continue;
+        }
+        if(!request.program_)
+            qWarning() << "ProgramCompiler: program failed, keeping fallback";
+        else if(request.ready_)
+            request.ready_(request.program_);
+        request.ready_ = nullptr; // release whatever the callback captured
+        pending_.erase(pending_.begin() + i);
+    }
+
+    return pending_.size();
+}
+
+void ProgramCompiler::build(Request &request)
+{
+    request.program_ = request.build_();
+    request.build_ = nullptr;
+
+    if(request.program_) {
+        // hand the program over to the GL thread
+        if(QThread::currentThread() != glThread_)
+            request.program_->moveToThread(glThread_);
+
+        // the program must be complete before another context uses it
+        glCore().glFinish();
+    }
+
+    request.done_.store(true, memory_order_release);
+}
+
+void ProgramCompiler::workerLoop()
+{
+    // the context lives on this thread only
+    QOpenGLContext context;
+    context.setFormat(shareContext_->format());
+    context.setShareContext(shareContext_);
+    if(!context.create() || !context.makeCurrent(surface_.get())) {
+        qWarning() << "ProgramCompiler: no shared context, compiling on the GL thread";
+        threaded_ = false;
+        return;
+    }
+
+    for(;;) {
+        shared_ptr<Request> request;
+        {
+            unique_lock<mutex> lock(mutex_);
+            wakeUp_.wait(lock, [this] { return !running_ || !queue_.empty(); });
+            if(!running_)
+                break;
+            request = queue_.front();
+            queue_.pop_front();
+        }
+        build(*request);
+    }
+
+    context.doneCurrent();
+}
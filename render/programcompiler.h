@@ -0,0 +1,109 @@
+#pragma once
+
+#include <QOpenGLShaderProgram>
+#include <QOpenGLContext>
+#include <QOffscreenSurface>
+
+#include <atomic>             // std::atomic
+#include <condition_variable> // std::condition_variable
+#include <deque>              // std::deque
+#include <functional>         // std::function
+#include <memory>             // std::shared_ptr, std::unique_ptr
+#include <mutex>              // std::mutex
+#include <thread>             // std::thread
+#include <vector>             // std::vector
+
+class QThread;
+
+/*
+ *  Compiles and links shader programs without blocking the GL thread.
+ *
+ *  All programs are submitted up front; a worker thread with its own
+ *  OpenGL context, sharing objects with the widget's context, builds
+ *  them one after the other while the GL thread keeps drawing frames
+ *  with fallback materials. Once a request is done its program can be
+ *  used from the GL thread (the worker finishes all its GL commands
+ *  first). A failed build leaves the request done without a program,
+ *  and the fallback stays in use.
+ *
+ *  If the platform has no threaded OpenGL, poll() builds one pending
+ *  program per call on the GL thread instead, so compilation is at
+ *  least spread over several frames.
+ *
+ *  Note: QOpenGLShaderProgram::link() queries the link status right
+ *  away, which blocks, so KHR_parallel_shader_compile would not help
+ *  here; the worker context is used on all drivers.
+ *
+ *  Usage:
+ *      auto request = compiler.submit([]{ return buildProgram(...); },
+ *                                     [mat](auto prog) { mat->setProgram(prog); });
+ *      ...
+ *      compiler.poll();   // once per frame, GL thread: runs the callbacks
+ *
+ */
+class ProgramCompiler
+{
+public:
+
+    // builds and links a program (any thread with a current context), nullptr on failure
+    using Build = std::function<std::shared_ptr<QOpenGLShaderProgram>()>;
+
+    // called on the GL thread when a program is ready
+    using Ready = std::function<void(std::shared_ptr<QOpenGLShaderProgram>)>;
+
+    /*
+     *  One submitted program. program() is nullptr until the request
+     *  is done, and stays nullptr if the build failed.
+     */
+    class Request {
+    public:
+        bool isDone() const { return done_.load(std::memory_order_acquire); }
+        std::shared_ptr<QOpenGLShaderProgram> program() const { return isDone()? program_ : nullptr; }
+    private:
+        friend class ProgramCompiler;
+        Build build_;
+        Ready ready_;
+        std::shared_ptr<QOpenGLShaderProgram> program_;
+        std::atomic<bool> done_{false};
+    };
+
+    // context: the GL thread's current context, worker objects are shared with it
+    explicit ProgramCompiler(QOpenGLContext* context);
+    ~ProgramCompiler();
+
+    // queue a program build; ready is called by poll() once it succeeded
+    std::shared_ptr<Request> submit(Build build, Ready ready = nullptr);
+
+    // GL thread: deliver finished programs; returns the number of requests still pending
+    size_t poll();
+
+    // is a worker thread compiling (or does poll() do the work)?
+    bool threaded() const { return threaded_.load(); }
+
+    // do not copy the compiler, it owns a thread
+    ProgramCompiler(const ProgramCompiler&) = delete;
+    ProgramCompiler& operator=(const ProgramCompiler&) = delete;
+
+protected:
+
+    // run a request's build and mark it done
+    void build(Request& request);
+
+    // worker thread: create the shared context, then build queued requests
+    void workerLoop();
+
+    QOpenGLContext* shareContext_;
+    QThread* glThread_;                          // programs are handed over to this thread
+    std::unique_ptr<QOffscreenSurface> surface_; // worker context draws nowhere
+
+    std::thread worker_;
+    std::atomic<bool> threaded_{false};          // worker is running and has a context
+    std::mutex mutex_;
+    std::condition_variable wakeUp_;
+    std::deque<std::shared_ptr<Request>> queue_; // not yet built
+    bool running_ = true;
+
+    // submitted, but ready callback not yet delivered (GL thread only)
+    std::vector<std::shared_ptr<Request>> pending_;
+
+};
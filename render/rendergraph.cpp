@@ -0,0 +1,167 @@
+#include "render/rendergraph.h"
+#include "render/glfunctions.h"
+#include "render/glstate.h"
+#include "render/renderstats.h"
+
+#include <assert.h>
+
+using namespace std;
+
+GLuint RenderGraph::Pass::texture(size_t i) const
+{
+    return graph_->textureOf(graph_->passes_[index_].inputs[i]);
+}
+
+QSize RenderGraph::Pass::inputSize(size_t i) const
+{
+    return graph_->images_[graph_->passes_[index_].inputs[i]].size;
+}
+
+QSize RenderGraph::Pass::outputSize() const
+{
+    return graph_->images_[graph_->passes_[index_].output].size;
+}
+
+RenderGraph::Handle RenderGraph::importTexture(const string &name, GLuint texture, const QSize &size)
+{
+    Image image;
+    image.name = name;
+    image.kind = Kind::Texture;
+    image.size = size;
+    image.texture = texture;
+    images_.push_back(image);
+    return Handle(images_.size() - 1);
+}
+
+RenderGraph::Handle RenderGraph::importTarget(const string &name,
+                                              shared_ptr<QOpenGLFramebufferObject> target)
+{
+    assert(target);
+    Image image;
+    image.name = name;
+    image.kind = Kind::Target;
+    image.size = target->size();
+    image.target = target;
+    image.kept = true;
+    images_.push_back(image);
+    return Handle(images_.size() - 1);
+}
+
+RenderGraph::Handle RenderGraph::screen(const QSize &size)
+{
+    Image image;
+    image.name = "screen";
+    image.kind = Kind::Screen;
+    image.size = size;
+    image.kept = true;
+    images_.push_back(image);
+    return Handle(images_.size() - 1);
+}
+
+RenderGraph::Handle RenderGraph::create(const string &name, const QSize &size,
+                                       RenderTargetPool::Format format)
+{
+    Image image;
+    image.name = name;
+    image.kind = Kind::Transient;
+    image.size = size;
+    image.format = format;
+    images_.push_back(image);
+    return Handle(images_.size() - 1);
+}
+
+void RenderGraph::addPass(const string &name, const vector<Handle> &inputs, Handle output,
+                          Execute execute)
+{
+    assert(output >= 0 && size_t(output) < images_.size());
+    assert(images_[output].writer < 0 && images_[output].kind != Kind::Texture);
+
+    images_[output].writer = int(passes_.size());
+    passes_.push_back({ name, inputs, output, execute });
+}
+
+void RenderGraph::keep(Handle image)
+{
+    images_[image].kept = true;
+}
+
+GLuint RenderGraph::textureOf(Handle image) const
+{
+    const Image& i = images_[image];
+    assert(i.kind != Kind::Screen);
+    return i.kind == Kind::Texture? i.texture : i.target->texture();
+}
+
+void RenderGraph::execute()
+{
+    auto& gl = glCore();
+    auto& stats = RenderStats::current();
+
+    // cull: walk backwards from the kept images, marking the passes they depend on
+    vector<bool> neededImage(images_.size(), false);
+    for(size_t i=0; i<images_.size(); i++)
+        neededImage[i] = images_[i].kept;
+    for(int p=int(passes_.size())-1; p>=0; p--) {
+        auto& pass = passes_[p];
+        pass.needed = neededImage[pass.output];
+        if(!pass.needed) {
+            stats.postPassesCulled++;
+            continue;
+        }
+        for(Handle in : pass.inputs) {
+            assert(images_[in].kind == Kind::Texture || images_[in].writer >= 0);
+            neededImage[in] = true;
+            if(images_[in].lastReader < p)
+                images_[in].lastReader = p;
+        }
+    }
+
+    // run, allocating transient images on first write and releasing them after the last read
+    GLint screen, viewport[4];
+    gl.glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &screen);
+    gl.glGetIntegerv(GL_VIEWPORT, viewport);
+
+    for(size_t p=0; p<passes_.size(); p++) {
+        auto& pass = passes_[p];
+        if(!pass.needed)
+            continue;
+
+        Image& out = images_[pass.output];
+        if(out.kind == Kind::Transient)
+            out.target = pool_.acquire(out.size, out.format);
+
+        if(out.kind == Kind::Screen) {
+            gl.glBindFramebuffer(GL_FRAMEBUFFER, GLuint(screen));
+            gl.glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        } else {
+            out.target->bind();
+            gl.glViewport(0, 0, out.size.width(), out.size.height());
+        }
+
+        Pass context;
+        context.graph_ = this;
+        context.index_ = p;
+        pass.execute(context);
+        stats.postPasses++;
+
+        // transient images nobody reads any more go back to the pool
+        for(Handle in : pass.inputs) {
+            Image& image = images_[in];
+            if(image.kind == Kind::Transient && image.lastReader == int(p) && image.target) {
+                pool_.release(image.target);
+                image.target = nullptr;
+            }
+        }
+        if(out.kind == Kind::Transient && out.lastReader < 0 && out.target) {
+            pool_.release(out.target);
+            out.target = nullptr;
+        }
+    }
+
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, GLuint(screen));
+    gl.glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+    stats.postTargets = pool_.size();
+
+    images_.clear();
+    passes_.clear();
+}
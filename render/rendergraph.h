@@ -0,0 +1,120 @@
+#pragma once
+
+#include "render/rendertargetpool.h"
+
+#include <QOpenGLFramebufferObject>
+#include <QSize>
+
+#include <functional> // std::function
+#include <memory>     // std::shared_ptr
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+/*
+ *  Per-frame graph of full-screen passes (post processing).
+ *
+ *  Passes are declared with the images they read and the one image they
+ *  write; nothing is drawn while the graph is built. execute() then
+ *   - culls passes whose output is not needed, i.e. does not reach the
+ *     screen, an imported target or an image marked with keep(),
+ *   - allocates the transient images from a RenderTargetPool when they
+ *     are first written and gives them back after their last read, so
+ *     images whose lifetimes do not overlap share one target,
+ *   - runs the remaining passes in declaration order, each with its
+ *     output bound and the viewport set to the output's size.
+ *
+ *  Each image is written by a single pass. The graph is rebuilt every
+ *  frame, so chains of any length can be assembled on the fly.
+ *
+ *  Usage:
+ *      RenderGraph graph(pool);
+ *      auto scene = graph.importTexture("scene", tex, size);
+ *      auto blurred = graph.create("blurred", size);
+ *      graph.addPass("blur", {scene}, blurred, [&](const RenderGraph::Pass& p) {
+ *          ... draw, reading p.texture(0) ...
+ *      });
+ *      graph.addPass("present", {blurred}, graph.screen(viewportSize), ...);
+ *      graph.execute();
+ *
+ */
+class RenderGraph
+{
+public:
+
+    // identifies an image in the graph
+    using Handle = int;
+
+    // what an executing pass can see
+    class Pass {
+    public:
+        // texture of the i-th input
+        GLuint texture(size_t i) const;
+        // size of the i-th input, and of the output
+        QSize inputSize(size_t i) const;
+        QSize outputSize() const;
+    private:
+        friend class RenderGraph;
+        const RenderGraph* graph_ = nullptr;
+        size_t index_ = 0;
+    };
+    using Execute = std::function<void(const Pass&)>;
+
+    explicit RenderGraph(RenderTargetPool& pool) : pool_(pool) {}
+
+    // an existing texture, read only
+    Handle importTexture(const std::string& name, GLuint texture, const QSize& size);
+
+    // an existing target, written by a pass and readable afterwards; always kept
+    Handle importTarget(const std::string& name, std::shared_ptr<QOpenGLFramebufferObject> target);
+
+    // the framebuffer bound when execute() is called; always kept
+    Handle screen(const QSize& size);
+
+    // a transient image, allocated from the pool while needed
+    Handle create(const std::string& name, const QSize& size,
+                  RenderTargetPool::Format format = RenderTargetPool::Format::Color);
+
+    // declare a pass, in execution order
+    void addPass(const std::string& name, const std::vector<Handle>& inputs, Handle output,
+                 Execute execute);
+
+    // size of an image
+    QSize size(Handle image) const { return images_[image].size; }
+
+    // passes writing this image must not be culled
+    void keep(Handle image);
+
+    // cull, allocate and run the passes; the graph is empty afterwards
+    void execute();
+
+protected:
+
+    enum class Kind { Texture, Target, Screen, Transient };
+
+    struct Image {
+        std::string name;
+        Kind kind;
+        QSize size;
+        RenderTargetPool::Format format = RenderTargetPool::Format::Color; // Transient
+        GLuint texture = 0;                                  // Texture
+        std::shared_ptr<QOpenGLFramebufferObject> target;    // Target, or Transient while allocated
+        bool kept = false;
+        int writer = -1;                                     // pass writing the image
+        int lastReader = -1;                                 // last pass reading it
+    };
+
+    struct PassDecl {
+        std::string name;
+        std::vector<Handle> inputs;
+        Handle output;
+        Execute execute;
+        bool needed = false;
+    };
+
+    // texture of an image while it is readable
+    GLuint textureOf(Handle image) const;
+
+    RenderTargetPool& pool_;
+    std::vector<Image> images_;
+    std::vector<PassDecl> passes_;
+};
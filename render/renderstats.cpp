@@ -0,0 +1,41 @@
+#include "render/renderstats.h"
+
+#include <QDebug>
+
+RenderStats& RenderStats::current()
+{
+    static RenderStats stats;
+    return stats;
+}
+
+QDebug operator<<(QDebug stream, const RenderStats &stats)
+{
+    stream.nospace() << "draw calls: " << stats.drawCalls
+                     << ", draw items: " << stats.drawItems
+                     << " (" << stats.frustumCulled << " frustum culled, "
+                     << stats.prepJobs << " jobs, " << stats.prepMilliseconds << " ms, "
+                     << stats.drawDataBytes << " bytes draw data, "
+                     << stats.materialUploads << " materials uploaded)"
+                     << ", uniforms: " << stats.uniformUploads
+                     << " (" << stats.uniformsSkipped << " skipped)"
+                     << ", state changes: " << stats.stateChanges
+                     << " (" << stats.stateChangesSkipped << " skipped)"
+                     << ", texture binds: " << stats.textureBinds
+                     << " (" << stats.textureBindsSkipped << " skipped)"
+                     << ", occlusion queries: " << stats.occlusionQueries
+                     << " (" << stats.occlusionProxies << " proxies, "
+                     << stats.occlusionConditional << " conditional, "
+                     << stats.occlusionCulled << " culled)"
+                     << ", light range: " << stats.lightCulled << " draws, "
+                     << stats.lightPassesSkipped << " passes skipped"
+                     << ", shadow tiles: " << stats.shadowTilesRendered
+                     << " (" << stats.shadowTilesCached << " cached, "
+                     << stats.shadowCasterDraws << " draws)"
+                     << ", clustered lights: " << stats.clusterLights
+                     << " (" << stats.clusterLightRefs << " references, "
+                     << stats.clusterMilliseconds << " ms)"
+                     << ", post passes: " << stats.postPasses
+                     << " (" << stats.postPassesCulled << " culled, "
+                     << stats.postTargets << " targets)";
+    return stream.space();
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef> // size_t
+
+class QDebug;
+
+/*
+ *  Counters collected while rendering a single frame.
+ *  The scene resets them at the beginning of each frame and
+ *  can print them periodically (see Scene::toggleStatsOutput()).
+ *
+ */
+struct RenderStats
+{
+    // actual draw calls issued (all passes)
+    size_t drawCalls = 0;
+
+    // frame preparation, see DrawListBuilder
+    size_t drawItems = 0;         // meshes in the draw list
+    size_t frustumCulled = 0;     // meshes outside the view frustum
+    size_t prepJobs = 0;          // traversal jobs
+    double prepMilliseconds = 0;  // CPU time for building the draw list
+    size_t drawDataBytes = 0;     // per-draw matrices streamed to the GPU, see DrawUniforms
+    size_t materialUploads = 0;   // material records that changed, see MaterialTable
+
+    // uniforms set through UniformCache
+    size_t uniformUploads = 0;    // values actually sent to the driver
+    size_t uniformsSkipped = 0;   // unchanged values, not sent
+
+    // state changes through GLState
+    size_t stateChanges = 0;        // calls that reached the driver
+    size_t stateChangesSkipped = 0; // redundant calls, not sent
+
+    // texture bindings through TextureUnits
+    size_t textureBinds = 0;        // textures bound to a unit
+    size_t textureBindsSkipped = 0; // textures still bound from an earlier draw
+
+    // occlusion queries, see OcclusionQuery
+    size_t occlusionQueries = 0;     // queries issued this frame
+    size_t occlusionProxies = 0;     // bounding boxes drawn for a query
+    size_t occlusionConditional = 0; // draws issued with conditional rendering
+    size_t occlusionCulled = 0;      // draws skipped since node was known to be hidden
+
+    // light passes restricted to a light's range, see LightBounds
+    size_t lightCulled = 0;         // draws skipped in a pass since out of the light's reach
+    size_t lightPassesSkipped = 0;  // passes skipped since the light is off screen
+
+    // shadow maps, see ShadowMaps
+    size_t shadowTilesRendered = 0; // atlas tiles (face and layer) rendered again
+    size_t shadowTilesCached = 0;   // atlas tiles still up to date
+    size_t shadowCasterDraws = 0;   // draw calls for rendering the tiles
+
+    // clustered lighting, see LightClusters
+    size_t clusterLights = 0;       // lights binned into clusters
+    size_t clusterLightRefs = 0;    // light indices over all clusters
+    double clusterMilliseconds = 0; // CPU time for binning and upload
+
+    // post processing, see RenderGraph
+    size_t postPasses = 0;        // full-screen passes executed
+    size_t postPassesCulled = 0;  // declared passes whose output was not needed
+    size_t postTargets = 0;       // render targets owned by the pool
+
+    // reset all counters to zero
+    void reset() { *this = RenderStats(); }
+
+    // the statistics of the frame currently being rendered
+    static RenderStats& current();
+};
+
+QDebug operator<<(QDebug stream, const RenderStats& stats);
+
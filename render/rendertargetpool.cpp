@@ -0,0 +1,64 @@
+#include "render/rendertargetpool.h"
+#include "render/glstate.h"
+
+#include <algorithm> // std::remove_if
+
+using namespace std;
+
+shared_ptr<QOpenGLFramebufferObject> RenderTargetPool::acquire(const QSize &size, Format format)
+{
+    for(auto& e : entries_) {
+        if(!e.inUse && e.format == format && e.target->size() == size) {
+            e.inUse = true;
+            e.lastUse = frame_;
+            return e.target;
+        }
+    }
+
+    bool depth = format == Format::ColorDepth || format == Format::HalfFloatDepth;
+    GLenum internalFormat = GL_RGBA8;
+    if(format == Format::HalfFloat || format == Format::HalfFloatDepth)
+        internalFormat = GL_RGBA16F;
+    else if(format == Format::Float)
+        internalFormat = GL_RGBA32F;
+
+    Entry e;
+    e.format = format;
+    e.target = make_shared<QOpenGLFramebufferObject>(
+                size,
+                depth? QOpenGLFramebufferObject::Depth : QOpenGLFramebufferObject::NoAttachment,
+                GLenum(GL_TEXTURE_2D), internalFormat);
+    e.inUse = true;
+    e.lastUse = frame_;
+    entries_.push_back(e);
+
+    // creating the FBO changed bindings behind the trackers' backs
+    GLState::current().invalidate();
+
+    return e.target;
+}
+
+void RenderTargetPool::release(const shared_ptr<QOpenGLFramebufferObject> &target)
+{
+    for(auto& e : entries_) {
+        if(e.target == target) {
+            e.inUse = false;
+            e.lastUse = frame_;
+            return;
+        }
+    }
+}
+
+void RenderTargetPool::endFrame()
+{
+    frame_++;
+    entries_.erase(remove_if(entries_.begin(), entries_.end(), [this](const Entry& e) {
+        return !e.inUse && frame_ - e.lastUse > keepFrames;
+    }), entries_.end());
+}
+
+void RenderTargetPool::clear()
+{
+    entries_.erase(remove_if(entries_.begin(), entries_.end(),
+                             [](const Entry& e) { return !e.inUse; }), entries_.end());
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QOpenGLFramebufferObject>
+#include <QSize>
+
+#include <memory> // std::shared_ptr
+#include <vector> // std::vector
+
+/*
+ *  Recycles framebuffer objects for render targets, e.g. the scene image
+ *  and the intermediate images of post processing (see RenderGraph).
+ *  Targets are keyed by size and format; a target that is released can
+ *  be handed out again, within the same frame or later. Targets unused
+ *  for a number of frames are deleted.
+ *
+ *  Each user asks for the format it needs, so e.g. post processing
+ *  images do not carry a depth buffer they never use.
+ *
+ */
+class RenderTargetPool
+{
+public:
+
+    enum class Format {
+        Color,          // RGBA8, no depth
+        HalfFloat,      // RGBA16F, no depth (feedback, HDR)
+        Float,          // RGBA32F, no depth (running sums)
+        ColorDepth,     // RGBA8 with depth renderbuffer (3D rendering)
+        HalfFloatDepth  // RGBA16F with depth renderbuffer (velocities)
+    };
+
+    // a target of exactly this size and format, reused if one is free
+    std::shared_ptr<QOpenGLFramebufferObject> acquire(const QSize& size,
+                                                      Format format = Format::Color);
+
+    // hand a target back, it may be given out again right away
+    void release(const std::shared_ptr<QOpenGLFramebufferObject>& target);
+
+    // end of frame: delete targets that have not been used for a while
+    void endFrame();
+
+    // delete all targets that are not in use
+    void clear();
+
+    // number of targets owned by the pool
+    size_t size() const { return entries_.size(); }
+
+    // frames a free target is kept
+    size_t keepFrames = 60;
+
+protected:
+
+    struct Entry {
+        std::shared_ptr<QOpenGLFramebufferObject> target;
+        Format format;
+        bool inUse = false;
+        size_t lastUse = 0;   // frame number
+    };
+    std::vector<Entry> entries_;
+
+    size_t frame_ = 0;
+};
@@ -0,0 +1,26 @@
+#include "render/shaderpermutations.h"
+
+using namespace std;
+
+shared_ptr<QOpenGLShaderProgram> ShaderPermutations::program(uint32_t features)
+{
+    auto& request = requests_[features];
+    if(!request)
+        request = factory_(defines(features));
+
+    // a variant that failed to build stays nullptr
+    return request->program();
+}
+
+string ShaderPermutations::defines(uint32_t features) const
+{
+    if(featureNames_.size() < 32 && (features >> featureNames_.size()))
+        qFatal("ShaderPermutations: unknown feature bit");
+
+    string result;
+    for(size_t i=0; i<featureNames_.size(); i++) {
+        if(features & (1u << i))
+            result += "#define " + featureNames_[i] + "\n";
+    }
+    return result;
+}
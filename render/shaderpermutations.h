@@ -0,0 +1,53 @@
+#pragma once
+
+#include "render/programcompiler.h"
+
+#include <cstdint>    // uint32_t
+#include <functional> // std::function
+#include <map>        // std::map
+#include <memory>     // std::shared_ptr
+#include <string>     // std::string
+#include <vector>     // std::vector
+
+/*
+ *  Compile-time specialized variants of one shader program.
+ *
+ *  Instead of testing feature flags at runtime, the shader source
+ *  guards each optional feature with #ifdef NAME. A variant is a set
+ *  of features (bit i = featureNames[i]); it is compiled with one
+ *  #define per feature the first time it is requested, and cached.
+ *  Only variants that are actually used are ever compiled.
+ *
+ *  The factory receives the #define lines and has to submit the
+ *  program to a ProgramCompiler (see Scene::createProgramAsync()),
+ *  so requesting a new variant does not block. GL thread only.
+ *
+ */
+class ShaderPermutations
+{
+public:
+
+    using Factory = std::function<std::shared_ptr<ProgramCompiler::Request>(const std::string& defines)>;
+
+    ShaderPermutations(std::vector<std::string> featureNames, Factory factory)
+        : featureNames_(std::move(featureNames)), factory_(std::move(factory))
+    {}
+
+    // program for a set of features, submitted on first use; nullptr until it is ready
+    std::shared_ptr<QOpenGLShaderProgram> program(uint32_t features);
+
+    // #define lines for a set of features
+    std::string defines(uint32_t features) const;
+
+    // number of variants requested so far
+    size_t size() const { return requests_.size(); }
+
+protected:
+
+    std::vector<std::string> featureNames_;
+    Factory factory_;
+
+    // requested variants, by feature bits
+    std::map<uint32_t, std::shared_ptr<ProgramCompiler::Request>> requests_;
+
+};
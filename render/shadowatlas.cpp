@@ -0,0 +1,102 @@
+#include "render/shadowatlas.h"
+#include "render/glstate.h"
+#include "render/textureunits.h"
+
+#include <algorithm> // std::find
+
+using namespace std;
+
+ShadowAtlas::ShadowAtlas(int tileSize, int tilesPerRow)
+    : tileSize_(tileSize), tilesPerRow_(tilesPerRow)
+{
+    auto& gl = glCore();
+    const int size = tileSize_ * tilesPerRow_;
+
+    // depth texture array; sampled with depth comparison, see TextureUnits::Sampler::Shadow
+    gl.glGenTextures(1, &texture_);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, texture_);
+    gl.glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_DEPTH_COMPONENT24, size, size, NumLayers,
+                    0, GL_DEPTH_COMPONENT, GL_UNSIGNED_INT, nullptr);
+    gl.glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+    // framebuffer without color, the layer is attached per tile
+    GLint previous;
+    gl.glGetIntegerv(GL_FRAMEBUFFER_BINDING, &previous);
+    gl.glGenFramebuffers(1, &fbo_);
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    gl.glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture_, 0, 0);
+    gl.glDrawBuffer(GL_NONE);
+    gl.glReadBuffer(GL_NONE);
+    if(gl.glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+        qFatal("ShadowAtlas: incomplete framebuffer");
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, GLuint(previous));
+
+    // texture bound behind the trackers' backs
+    GLState::current().invalidate();
+    TextureUnits::current().invalidate();
+
+    // hand out low indices first
+    for(int i=tilesPerRow_ * tilesPerRow_ - 1; i>=0; i--)
+        free_.push_back(i);
+}
+
+ShadowAtlas::~ShadowAtlas()
+{
+    if(!QOpenGLContext::currentContext())
+        return;
+    auto& gl = glCore();
+    gl.glDeleteFramebuffers(1, &fbo_);
+    gl.glDeleteTextures(1, &texture_);
+}
+
+int ShadowAtlas::acquire()
+{
+    if(free_.empty())
+        return -1;
+    int tile = free_.back();
+    free_.pop_back();
+    return tile;
+}
+
+void ShadowAtlas::release(int tile)
+{
+    if(tile >= 0 && find(free_.begin(), free_.end(), tile) == free_.end())
+        free_.push_back(tile);
+}
+
+void ShadowAtlas::beginTile(int tile, Layer layer)
+{
+    auto& gl = glCore();
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, fbo_);
+    gl.glFramebufferTextureLayer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, texture_, 0, layer);
+
+    const int x = (tile % tilesPerRow_) * tileSize_, y = (tile / tilesPerRow_) * tileSize_;
+    gl.glViewport(x, y, tileSize_, tileSize_);
+    gl.glScissor(x, y, tileSize_, tileSize_);
+    GLState::current().enable(GL_SCISSOR_TEST);
+
+    gl.glDepthMask(GL_TRUE);
+    gl.glClear(GL_DEPTH_BUFFER_BIT);
+}
+
+QMatrix4x4 ShadowAtlas::tileMatrix(int tile) const
+{
+    // NDC [-1,1] -> tile area in [0,1] texture coordinates, depth [-1,1] -> [0,1]
+    const float scale = 1.0f / tilesPerRow_;
+    const float x = float(tile % tilesPerRow_) * scale, y = float(tile / tilesPerRow_) * scale;
+
+    QMatrix4x4 m;
+    m.translate(x + 0.5f * scale, y + 0.5f * scale, 0.5f);
+    m.scale(0.5f * scale, 0.5f * scale, 0.5f);
+    return m;
+}
+
+QMatrix4x4 ShadowAtlas::guardBand() const
+{
+    // shrink clip x, y so [-1,1] ends up guardTexels away from the tile edges
+    const float inner = float(tileSize_ - 2 * guardTexels) / tileSize_;
+
+    QMatrix4x4 m;
+    m.scale(inner, inner, 1.0f);
+    return m;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "render/glfunctions.h"
+
+#include <QMatrix4x4>
+
+#include <vector> // std::vector
+
+/*
+ *  Pool of square shadow map tiles in one depth texture array.
+ *
+ *  The atlas has one layer per kind of shadow caster (static, dynamic);
+ *  a tile index stands for the same area in every layer, so a shadow
+ *  map keeps both layers side by side. Tiles are handed out and taken
+ *  back by the users (see ShadowMaps), the texture is never resized.
+ *
+ *  Shaders sample the atlas with depth comparison (hardware PCF):
+ *      uniform sampler2DArrayShadow shadowAtlas;
+ *      float lit = texture(shadowAtlas, vec4(uv, layer, depth));
+ *
+ */
+class ShadowAtlas
+{
+public:
+
+    enum Layer { Static, Dynamic, NumLayers };
+
+    // tileSize x tileSize texels per tile, tilesPerRow^2 tiles per layer
+    explicit ShadowAtlas(int tileSize = 512, int tilesPerRow = 4);
+    ~ShadowAtlas();
+
+    // take a free tile, -1 if all are in use
+    int acquire();
+
+    // give a tile back to the pool
+    void release(int tile);
+
+    // number of tiles not in use
+    size_t freeTiles() const { return free_.size(); }
+
+    /*
+     *  Start rendering depth into a tile of a layer: binds the atlas
+     *  framebuffer, restricts viewport and scissor rectangle to the
+     *  tile and clears its depth. Leaves the scissor test enabled.
+     */
+    void beginTile(int tile, Layer layer);
+
+    // maps clip coordinates of a shadow map's projection to the tile (uv) and depth range [0,1]
+    QMatrix4x4 tileMatrix(int tile) const;
+
+    /*
+     *  Guard band around the edges of a tile. Multiply a shadow map's
+     *  projection with this matrix (guardBand() * projection): its view
+     *  volume then ends guardTexels inside the tile, and the border gets
+     *  the depth just outside it. Hardware PCF reads a 2x2 footprint, so
+     *  without this, lookups at the edge of the volume (cube face seams)
+     *  would read the neighbouring tile.
+     */
+    QMatrix4x4 guardBand() const;
+    static const int guardTexels = 1;
+
+    GLuint texture() const { return texture_; }
+
+    // do not copy, owns OpenGL objects
+    ShadowAtlas(const ShadowAtlas&) = delete;
+    ShadowAtlas& operator=(const ShadowAtlas&) = delete;
+
+protected:
+
+    int tileSize_, tilesPerRow_;
+
+    // depth texture array and the framebuffer rendering into it
+    GLuint texture_ = 0, fbo_ = 0;
+
+    // tiles not in use
+    std::vector<int> free_;
+};
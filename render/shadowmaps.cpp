@@ -0,0 +1,205 @@
+#include "render/shadowmaps.h"
+#include "render/frustum.h"
+#include "render/glstate.h"
+#include "render/renderstats.h"
+#include "render/textureunits.h"
+
+#include <algorithm> // std::min
+#include <cstring>   // std::memcpy
+
+using namespace std;
+
+namespace {
+
+// FNV-1a, over the bytes of a value
+uint64_t hashBytes(uint64_t h, const void* data, size_t size)
+{
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for(size_t i=0; i<size; i++)
+        h = (h ^ p[i]) * 1099511628211ull;
+    return h;
+}
+
+const uint64_t hashSeed = 14695981039346656037ull;
+
+// view direction and up vector of the cube faces +X, -X, +Y, -Y, +Z, -Z
+const QVector3D faceDirections[6][2] = {
+    { QVector3D( 1, 0, 0), QVector3D(0,-1, 0) },
+    { QVector3D(-1, 0, 0), QVector3D(0,-1, 0) },
+    { QVector3D( 0, 1, 0), QVector3D(0, 0, 1) },
+    { QVector3D( 0,-1, 0), QVector3D(0, 0,-1) },
+    { QVector3D( 0, 0, 1), QVector3D(0,-1, 0) },
+    { QVector3D( 0, 0,-1), QVector3D(0,-1, 0) }
+};
+
+}
+
+ShadowMaps::ShadowMaps(shared_ptr<Material> depthMaterial, int tileSize)
+    : atlas_(tileSize), depthMaterial_(depthMaterial)
+{
+    if(!depthMaterial_)
+        qFatal("ShadowMaps: need a depth material");
+
+    for(int i=0; i<6 * maxLights; i++)
+        matrixNames_.push_back("shadowMatrices[" + to_string(i) + "]");
+    for(int k=0; k<maxLights; k++)
+        lightNames_.push_back("shadowLights[" + to_string(k) + "]");
+}
+
+ShadowMaps::~ShadowMaps()
+{
+    for(auto& maps : lights_)
+        for(auto& face : maps.faces)
+            atlas_.release(face.tile);
+}
+
+void ShadowMaps::placeLight(LightMaps &maps, const Light &light)
+{
+    maps.position_WC = light.position_WC;
+    maps.far = light.range > 0? light.range : farPlane;
+
+    for(int f=0; f<6; f++) {
+        Face& face = maps.faces[f];
+        face.view.setToIdentity();
+        face.view.lookAt(light.position_WC, light.position_WC + faceDirections[f][0],
+                         faceDirections[f][1]);
+        // the 90 degree face plus a guard band, so PCF at the seams stays in the tile
+        face.projection = atlas_.guardBand();
+        face.projection.perspective(90.0f, 1.0f, nearPlane, maps.far);
+        face.atlasMatrix = atlas_.tileMatrix(face.tile) * face.projection * face.view;
+        for(auto& v : face.valid)
+            v = false;
+    }
+}
+
+ShadowAtlas::Layer ShadowMaps::layerOf(const DrawItem &item) const
+{
+    auto c = casters_.find(item.node);
+    bool isStatic = c != casters_.end() && c->second.unchangedFrames >= staticFrames;
+    return isStatic? ShadowAtlas::Static : ShadowAtlas::Dynamic;
+}
+
+void ShadowMaps::updateLayer(Face &face, ShadowAtlas::Layer layer, const DrawList &casters)
+{
+    auto& stats = RenderStats::current();
+
+    // casters of this layer inside the face's frustum
+    Frustum frustum(face.projection * face.view);
+    vector<const DrawItem*> inside;
+    uint64_t signature = hashSeed;
+    for(const auto& item : casters.items) {
+        if(layerOf(item) != layer || !frustum.intersects(item.mesh->geometry()->bbox(), item.modelMatrix))
+            continue;
+        inside.push_back(&item);
+        signature = hashBytes(signature, &item.mesh, sizeof(item.mesh));
+        signature = hashBytes(signature, item.modelMatrix.constData(), 16 * sizeof(float));
+    }
+
+    if(face.valid[layer] && face.signature[layer] == signature) {
+        stats.shadowTilesCached++;
+        return;
+    }
+
+    // render the casters' depth into the tile
+    atlas_.beginTile(face.tile, layer);
+    Camera cam(face.view, face.projection);
+    for(const DrawItem* item : inside) {
+        cam.setShaderTransformationMatrices(*depthMaterial_, item->modelMatrix);
+        item->mesh->draw(*depthMaterial_);
+    }
+
+    face.signature[layer] = signature;
+    face.valid[layer] = true;
+    stats.shadowTilesRendered++;
+    stats.shadowCasterDraws += inside.size();
+}
+
+void ShadowMaps::update(const vector<Light> &lights, const DrawList &casters)
+{
+    auto& gl = glCore();
+    auto& state = GLState::current();
+    frame_++;
+
+    // which casters have moved since the last frame?
+    for(const auto& item : casters.items) {
+        auto& c = casters_[item.node];
+        if(c.lastSeen == 0 || !(c.modelMatrix == item.modelMatrix)) {
+            c.modelMatrix = item.modelMatrix;
+            c.unchangedFrames = 0;
+        } else {
+            c.unchangedFrames++;
+        }
+        c.lastSeen = frame_;
+    }
+    for(auto c = casters_.begin(); c != casters_.end(); ) {
+        if(c->second.lastSeen != frame_)
+            c = casters_.erase(c);
+        else
+            ++c;
+    }
+
+    // one set of tiles per light; give back the tiles of lights that went away
+    size_t n = min(lights.size(), size_t(maxLights));
+    while(lights_.size() > n) {
+        for(auto& face : lights_.back().faces)
+            atlas_.release(face.tile);
+        lights_.pop_back();
+    }
+    lights_.resize(n);
+
+    // remember the current target, shadow maps are rendered into the atlas
+    GLint framebuffer, viewport[4];
+    gl.glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    gl.glGetIntegerv(GL_VIEWPORT, viewport);
+
+    state.enable(GL_DEPTH_TEST);
+    state.depthFunc(GL_LESS);
+    state.disable(GL_BLEND);
+    state.enable(GL_POLYGON_OFFSET_FILL);
+    gl.glPolygonOffset(offsetFactor, offsetUnits);
+
+    for(size_t i=0; i<n; i++) {
+        LightMaps& maps = lights_[i];
+        maps.index = lights[i].index;
+
+        // all six tiles, or no shadows for this light
+        if(maps.faces[0].tile < 0) {
+            if(atlas_.freeTiles() < 6)
+                continue;
+            for(auto& face : maps.faces)
+                face.tile = atlas_.acquire();
+            maps.far = 0;
+        }
+
+        // a moved light invalidates everything it sees
+        float far = lights[i].range > 0? lights[i].range : farPlane;
+        if(maps.position_WC != lights[i].position_WC || maps.far != far)
+            placeLight(maps, lights[i]);
+
+        for(auto& face : maps.faces) {
+            updateLayer(face, ShadowAtlas::Static, casters);
+            updateLayer(face, ShadowAtlas::Dynamic, casters);
+        }
+    }
+
+    state.disable(GL_POLYGON_OFFSET_FILL);
+    state.disable(GL_SCISSOR_TEST);
+    gl.glBindFramebuffer(GL_FRAMEBUFFER, GLuint(framebuffer));
+    gl.glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+void ShadowMaps::apply(UniformCache &uniforms) const
+{
+    int unit = TextureUnits::current().bind(GL_TEXTURE_2D_ARRAY, atlas_.texture(),
+                                            TextureUnits::Sampler::Shadow);
+    uniforms.set("shadowAtlas", unit);
+
+    for(int k=0; k<maxLights; k++) {
+        bool used = size_t(k) < lights_.size() && lights_[k].faces[0].tile >= 0;
+        uniforms.set(lightNames_[k].c_str(), used? lights_[k].index : -1);
+        if(!used)
+            continue;
+        for(int f=0; f<6; f++)
+            uniforms.set(matrixNames_[6*k + f].c_str(), lights_[k].faces[f].atlasMatrix);
+    }
+}
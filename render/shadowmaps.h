@@ -0,0 +1,126 @@
+#pragma once
+
+#include "render/shadowatlas.h"
+#include "render/drawlist.h"
+#include "render/uniformcache.h"
+#include "material/material.h"
+
+#include <QMatrix4x4>
+#include <QVector3D>
+
+#include <array>         // std::array
+#include <cstdint>       // uint64_t
+#include <memory>        // std::shared_ptr
+#include <string>        // std::string
+#include <unordered_map> // std::unordered_map
+#include <vector>        // std::vector
+
+/*
+ *  Cached omnidirectional shadow maps for point lights.
+ *
+ *  Each light gets six tiles of a ShadowAtlas, one per cube face. Shadow
+ *  casters are split into two layers: static casters go into the static
+ *  layer, dynamic casters into the dynamic layer, and the shaders test
+ *  against both. A layer of a face is only rendered again when the light
+ *  has moved, or when the set of casters of that kind inside the face's
+ *  frustum (or one of their transformations) has changed. A moving
+ *  object therefore only costs the dynamic layer of the faces it is in.
+ *
+ *  Casters are classified automatically: a node whose model matrix has
+ *  not changed for staticFrames frames is static, a node that moves is
+ *  dynamic again (which invalidates the static layer once, since the
+ *  caster left it).
+ *
+ *  GLSL side (see the SHADOWS variant of textured_phong.frag):
+ *      uniform sampler2DArrayShadow shadowAtlas;  // layers: static, dynamic
+ *      uniform mat4 shadowMatrices[12];           // per shadowed light: 6 faces, WC -> atlas
+ *      uniform int  shadowLights[2];              // FrameData index of each shadowed light, -1: none
+ *
+ */
+class ShadowMaps
+{
+public:
+
+    // lights with shadows at the same time (size of the arrays in the shaders)
+    static const int maxLights = 2;
+
+    // frames without change until a caster counts as static
+    static const int staticFrames = 30;
+
+    struct Light {
+        int index;              // index in the FrameData lights
+        QVector3D position_WC;
+        float range = 0;        // far plane of the shadow maps; <= 0: farPlane
+    };
+
+    // depthMaterial renders the casters (matrix uniforms, see Camera)
+    explicit ShadowMaps(std::shared_ptr<Material> depthMaterial, int tileSize = 512);
+    ~ShadowMaps();
+
+    /*
+     *  Bring the shadow maps of the lights (at most maxLights) up to date
+     *  (GL thread). casters holds all meshes that cast shadows, not culled
+     *  against the camera. Restores the framebuffer binding and viewport.
+     */
+    void update(const std::vector<Light>& lights, const DrawList& casters);
+
+    // bind the atlas and set the shadow uniforms of a program (during apply())
+    void apply(UniformCache& uniforms) const;
+
+    // shadow map projection for unbounded lights
+    float nearPlane = 0.05f;
+    float farPlane = 50.0f;
+
+    // depth bias while rendering the casters, see glPolygonOffset()
+    float offsetFactor = 2.0f;
+    float offsetUnits = 4.0f;
+
+    // do not copy, owns atlas tiles
+    ShadowMaps(const ShadowMaps&) = delete;
+    ShadowMaps& operator=(const ShadowMaps&) = delete;
+
+protected:
+
+    // one cube face of a light
+    struct Face {
+        QMatrix4x4 view, projection;
+        QMatrix4x4 atlasMatrix;                            // WC -> tile coordinates and depth
+        uint64_t signature[ShadowAtlas::NumLayers] = {};   // casters in the face's frustum
+        bool valid[ShadowAtlas::NumLayers] = {};           // layer rendered at least once
+        int tile = -1;
+    };
+
+    // the shadow maps of a light
+    struct LightMaps {
+        int index = -1;
+        QVector3D position_WC;
+        float far = 0;
+        std::array<Face,6> faces;
+    };
+
+    // what is known about a caster's transformation
+    struct Caster {
+        QMatrix4x4 modelMatrix;
+        int unchangedFrames = 0;
+        size_t lastSeen = 0;
+    };
+
+    // set up the faces of a light at a new position, all layers invalid
+    void placeLight(LightMaps& maps, const Light& light);
+
+    // render one layer of a face, if its casters have changed
+    void updateLayer(Face& face, ShadowAtlas::Layer layer, const DrawList& casters);
+
+    // static or dynamic?
+    ShadowAtlas::Layer layerOf(const DrawItem& item) const;
+
+    ShadowAtlas atlas_;
+    std::shared_ptr<Material> depthMaterial_;
+
+    std::vector<LightMaps> lights_;
+    std::unordered_map<const Node*, Caster> casters_;
+    size_t frame_ = 0;
+
+    // uniform names, "shadowMatrices[i]" and "shadowLights[k]"
+    std::vector<std::string> matrixNames_, lightNames_;
+};
@@ -0,0 +1,109 @@
+#include "render/textureunits.h"
+#include "render/glfunctions.h"
+#include "render/glstate.h"
+#include "render/renderstats.h"
+
+#include <algorithm> // std::min
+#include <memory>    // std::unique_ptr
+
+using namespace std;
+
+TextureUnits& TextureUnits::current()
+{
+    // one allocator per context, like GLState
+    static thread_local QOpenGLContext* context = nullptr;
+    static thread_local unique_ptr<TextureUnits> units;
+
+    auto ctx = QOpenGLContext::currentContext();
+    if(ctx != context || !units) {
+        units = make_unique<TextureUnits>();
+        context = ctx;
+    }
+    return *units;
+}
+
+TextureUnits::TextureUnits()
+{
+    // a unit may be used by the vertex or by the fragment shader
+    GLint maxUnits = 16;
+    glCore().glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+    units_.resize(size_t(min(maxUnits, 32)));
+    samplers_.resize(5, 0);
+}
+
+GLuint TextureUnits::samplerObject(Sampler sampler)
+{
+    GLuint& s = samplers_[size_t(sampler)];
+    if(s)
+        return s;
+
+    auto& gl = glCore();
+    gl.glGenSamplers(1, &s);
+
+    GLint wrap = sampler == Sampler::Mipmapped? GL_REPEAT : GL_CLAMP_TO_EDGE;
+    GLint magFilter = sampler == Sampler::Screen? GL_NEAREST : GL_LINEAR;
+    GLint minFilter = magFilter;
+    if(sampler == Sampler::Mipmapped || sampler == Sampler::CubeMap)
+        minFilter = GL_LINEAR_MIPMAP_LINEAR;
+
+    gl.glSamplerParameteri(s, GL_TEXTURE_WRAP_S, wrap);
+    gl.glSamplerParameteri(s, GL_TEXTURE_WRAP_T, wrap);
+    gl.glSamplerParameteri(s, GL_TEXTURE_WRAP_R, wrap);
+    gl.glSamplerParameteri(s, GL_TEXTURE_MIN_FILTER, minFilter);
+    gl.glSamplerParameteri(s, GL_TEXTURE_MAG_FILTER, magFilter);
+
+    // shadow maps: sampling returns the fraction of texels that pass the comparison
+    if(sampler == Sampler::Shadow) {
+        gl.glSamplerParameteri(s, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+        gl.glSamplerParameteri(s, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+    }
+
+    return s;
+}
+
+int TextureUnits::bind(GLenum target, GLuint texture, Sampler sampler)
+{
+    auto& stats = RenderStats::current();
+
+    // already bound to some unit?
+    size_t unit = units_.size();
+    for(size_t i=0; i<units_.size(); i++) {
+        if(units_[i].texture == texture && units_[i].target == target) {
+            unit = i;
+            break;
+        }
+    }
+
+    if(unit < units_.size()) {
+        stats.textureBindsSkipped++;
+    } else {
+        // least recently used unit that the current draw does not need
+        for(size_t i=0; i<units_.size(); i++) {
+            if(units_[i].lastUse < drawStamp_ &&
+               (unit == units_.size() || units_[i].lastUse < units_[unit].lastUse))
+                unit = i;
+        }
+        if(unit == units_.size())
+            qFatal("TextureUnits: too many textures in a single draw call");
+
+        GLState::current().bindTexture(int(unit), target, texture);
+        units_[unit].target = target;
+        units_[unit].texture = texture;
+        stats.textureBinds++;
+    }
+
+    GLuint s = samplerObject(sampler);
+    if(units_[unit].sampler != s) {
+        glCore().glBindSampler(GLuint(unit), s);
+        units_[unit].sampler = s;
+    }
+
+    units_[unit].lastUse = drawStamp_;
+    return int(unit);
+}
+
+void TextureUnits::invalidate()
+{
+    for(auto& u : units_)
+        u = Unit();
+}
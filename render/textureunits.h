@@ -0,0 +1,75 @@
+#pragma once
+
+#include <QOpenGLTexture>
+
+#include <vector> // std::vector
+
+/*
+ *  Assigns texture units to textures, instead of materials using
+ *  hard-coded units. A texture that is still bound to some unit from
+ *  an earlier draw is not bound again, its unit is simply reused; the
+ *  material sets its sampler uniform to the returned unit (which the
+ *  UniformCache skips if unchanged). Otherwise the least recently used
+ *  unit that is not needed by the current draw is taken.
+ *
+ *  So a texture shared by several materials (e.g. the cube map used as
+ *  sky box and as environment map) stays bound as long as it is used.
+ *
+ *  Filtering and wrapping are defined by sampler objects bound to the
+ *  unit along with the texture, not by per-texture parameters.
+ *
+ *  Usage, per draw call:
+ *      TextureUnits::current().nextDraw();          // see Mesh::draw()
+ *      int unit = units.bind(*tex, TextureUnits::Sampler::Mipmapped);
+ *      uniforms_->set("diffuseTexture", unit);
+ *
+ */
+class TextureUnits
+{
+public:
+
+    // sampler states in use
+    enum class Sampler {
+        Mipmapped,    // trilinear, repeat (textures with mip maps)
+        CubeMap,      // trilinear, clamp to edge
+        Screen,       // nearest, clamp to edge (FBO textures, post processing)
+        ScreenLinear, // linear, clamp to edge (FBO textures, filtered taps)
+        Shadow        // linear, clamp to edge, depth comparison (shadow maps)
+    };
+
+    // units of the current context, created on first use
+    static TextureUnits& current();
+
+    // a new draw call starts: textures of earlier draws may be replaced
+    void nextDraw() { drawStamp_++; }
+
+    // bind a texture (if not bound yet) for the current draw, returns its unit
+    int bind(GLenum target, GLuint texture, Sampler sampler);
+    int bind(const QOpenGLTexture& tex, Sampler sampler)
+    { return bind(GLenum(tex.target()), tex.textureId(), sampler); }
+
+    // forget what is bound, see GLState::invalidate()
+    void invalidate();
+
+    // sampler object for a sampler state (owned by the context)
+    GLuint samplerObject(Sampler sampler);
+
+    TextureUnits();
+
+protected:
+
+    struct Unit {
+        GLenum target = 0;
+        GLuint texture = 0;
+        GLuint sampler = 0;
+        size_t lastUse = 0;   // draw stamp of the last draw using the unit
+    };
+    std::vector<Unit> units_;
+
+    // one sampler object per Sampler value, created on first use
+    std::vector<GLuint> samplers_;
+
+    // identifies the current draw
+    size_t drawStamp_ = 1;
+};
+
@@ -0,0 +1,99 @@
+#include "render/uniformcache.h"
+#include "render/renderstats.h"
+
+#include <cstring>       // std::strcmp, std::memcmp
+#include <memory>        // std::unique_ptr
+#include <unordered_map> // std::unordered_map
+
+using namespace std;
+
+UniformCache& UniformCache::of(QOpenGLShaderProgram &prog)
+{
+    // GL thread only
+    static unordered_map<const QOpenGLShaderProgram*, unique_ptr<UniformCache>> caches;
+
+    auto& cache = caches[&prog];
+    if(!cache) {
+        cache = make_unique<UniformCache>(prog);
+
+        // a new program at the same address must not find the old values
+        const QOpenGLShaderProgram* key = &prog;
+        QObject::connect(&prog, &QObject::destroyed, [key] { caches.erase(key); });
+    }
+    return *cache;
+}
+
+UniformCache::Entry& UniformCache::entry(const char *name)
+{
+    for(auto& e : entries_)
+        if(strcmp(e.name.c_str(), name) == 0)
+            return e;
+
+    // first use: resolve the location once
+    entries_.push_back({ name, prog_.uniformLocation(name), false, {} });
+    return entries_.back();
+}
+
+bool UniformCache::changed(Entry &e, const float *data, size_t count)
+{
+    auto& stats = RenderStats::current();
+
+    if(e.location < 0)
+        return false;
+
+    if(e.valid && memcmp(e.shadow, data, count * sizeof(float)) == 0) {
+        stats.uniformsSkipped++;
+        return false;
+    }
+
+    memcpy(e.shadow, data, count * sizeof(float));
+    e.valid = true;
+    stats.uniformUploads++;
+    return true;
+}
+
+void UniformCache::set(const char *name, GLint value)
+{
+    Entry& e = entry(name);
+    float data[1];
+    memcpy(data, &value, sizeof(value));
+    if(changed(e, data, 1))
+        prog_.setUniformValue(e.location, value);
+}
+
+void UniformCache::set(const char *name, GLfloat value)
+{
+    Entry& e = entry(name);
+    if(changed(e, &value, 1))
+        prog_.setUniformValue(e.location, value);
+}
+
+void UniformCache::set(const char *name, const QVector3D &value)
+{
+    Entry& e = entry(name);
+    float data[3] = { value.x(), value.y(), value.z() };
+    if(changed(e, data, 3))
+        prog_.setUniformValue(e.location, value);
+}
+
+void UniformCache::set(const char *name, const QVector4D &value)
+{
+    Entry& e = entry(name);
+    float data[4] = { value.x(), value.y(), value.z(), value.w() };
+    if(changed(e, data, 4))
+        prog_.setUniformValue(e.location, value);
+}
+
+void UniformCache::set(const char *name, const QMatrix3x3 &value)
+{
+    Entry& e = entry(name);
+    if(changed(e, value.constData(), 9))
+        prog_.setUniformValue(e.location, value);
+}
+
+void UniformCache::set(const char *name, const QMatrix4x4 &value)
+{
+    Entry& e = entry(name);
+    if(changed(e, value.constData(), 16))
+        prog_.setUniformValue(e.location, value);
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <QOpenGLShaderProgram>
+#include <QMatrix4x4>
+#include <QVector3D>
+#include <QVector4D>
+
+#include <string> // std::string
+#include <vector> // std::vector
+
+/*
+ *  Uniform state of one shader program: locations are looked up only
+ *  once per name, and the last value uploaded to each uniform is kept
+ *  as a shadow copy, so setting an unchanged value does not reach the
+ *  driver. Uploads and skipped uploads are counted in RenderStats.
+ *
+ *  Uniforms are program state, so there is exactly one cache per
+ *  program (see of()), shared by all materials using that program.
+ *  All uniforms of a program must be set through its cache, otherwise
+ *  the shadow copies are out of date.
+ *
+ *  The setters expect the program to be bound.
+ *
+ */
+class UniformCache
+{
+public:
+
+    explicit UniformCache(QOpenGLShaderProgram& prog) : prog_(prog) {}
+
+    // cache of a program, created on first use, removed with the program
+    static UniformCache& of(QOpenGLShaderProgram& prog);
+
+    // set uniform values, unless unchanged since the last call
+    void set(const char* name, GLint value);
+    void set(const char* name, GLfloat value);
+    void set(const char* name, bool value) { set(name, GLint(value)); }
+    void set(const char* name, const QVector3D& value);
+    void set(const char* name, const QVector4D& value);
+    void set(const char* name, const QMatrix3x3& value);
+    void set(const char* name, const QMatrix4x4& value);
+
+    // location of a uniform, -1 if the program does not use it
+    GLint location(const char* name) { return entry(name).location; }
+
+protected:
+
+    struct Entry {
+        std::string name;
+        GLint location;
+        bool valid;           // shadow holds the uploaded value
+        float shadow[16];
+    };
+
+    // look up (or add) the entry for a uniform name
+    Entry& entry(const char* name);
+
+    // compare with and update the shadow copy; true if an upload is needed
+    bool changed(Entry& e, const float* data, size_t count);
+
+    QOpenGLShaderProgram& prog_;
+
+    // a program has few uniforms, a linear search is fastest
+    std::vector<Entry> entries_;
+};
+
@@ -3,14 +3,26 @@
 #include <iostream> // std::cout etc.
 #include <assert.h> // assert()
 #include <random>   // random number generation
+#include <algorithm> // std::find
 
 #include "geometry/cube.h" // geom::Cube
 #include "geometry/parametric.h" // geom::Sphere, geom::Torus
 
 #include "cubemap.h"
+#include "material/depthonly.h"
+#include "material/deferredlight.h"
+#include "material/separableblur.h"
+#include "material/dualfilter.h"
+#include "material/motionblur.h"
+#include "render/lightbounds.h"
+#include "render/renderstats.h"
+#include "render/glstate.h"
+#include "jobs/jobsystem.h"
+#include "mesh/objloader.h"
 
 #include <QtMath>
 #include <QMessageBox>
+#include <QFile>
 
 using namespace std;
 
@@ -38,10 +50,28 @@ Scene::Scene(QWidget* parent, QOpenGLContext *context) :
         int texsize;
         glGetIntegerv(GL_MAX_TEXTURE_SIZE, &texsize);
         cout << "max texture size: " << texsize << "x" << texsize << endl;
+
+        // without binary formats, the shader disk cache cannot be used
+        int binaryFormats;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &binaryFormats);
+        cout << "program binary formats: " << binaryFormats << endl;
     }
 
+    // uniform buffer for per-frame data, needed by all programs
+    frameUniforms_ = std::make_unique<FrameUniforms>();
+    drawUniforms_ = std::make_unique<DrawUniforms>();
+    materialTable_ = std::make_unique<MaterialTable>();
+    lightClusters_ = std::make_unique<LightClusters>();
+    for(auto& timer : forwardTimers_)
+        timer = std::make_unique<GpuTimer>();
+
+    // compiles programs in the background while assets are loaded and frames are drawn
+    programCompiler_ = std::make_unique<ProgramCompiler>(context);
+
     // construct map of nodes
     makeNodes();
+    cout << "blocking shader programs: " << programsCreated_ << " in "
+         << programMilliseconds_ << " ms" << endl;
 
     // from the nodes, construct a hierarchical scene (adding more nodes)
     makeScene();
@@ -61,66 +91,154 @@ Scene::Scene(QWidget* parent, QOpenGLContext *context) :
 
 void Scene::makeNodes()
 {
-    // load textures
-    std::shared_ptr<QOpenGLTexture> cubetex = makeCubeMap(":/textures/bridge2048");
-    std::shared_ptr<QOpenGLTexture> stdtex = std::make_shared<QOpenGLTexture>(QImage(":/textures/RTR-ist-super-4-3.png"));
+    auto& jobs = JobSystem::instance();
 
-    // make sky box material (tex unit 1)
+    // programs that are needed right away, and cheap fallbacks for all others
     auto sky_prog = createProgram(":/shaders/skybox.vert", ":/shaders/skybox.frag");
-    auto skymat = make_shared<SkyBoxMaterial>(sky_prog,1);
-
-    // sky box object, can draw a skybox around a give camera, not part of the scene
-    skymat->texture = cubetex;
-    skybox_ = make_shared<SkyBox>(skymat, nullptr, nullptr);
-
-    // load shader source files and compile them into OpenGL program objects
-    auto phong_prog = createProgram(":/shaders/textured_phong.vert", ":/shaders/textured_phong.frag");
+    auto fallback_phong = createProgram(":/shaders/phong.vert", ":/shaders/phong.frag");
+    auto orig = createProgram(":/shaders/post.vert", ":/shaders/original.frag");
+    auto depth_prog = createProgram(":/shaders/depth_only.vert", ":/shaders/depth_only.frag");
+
+    // textured Phong programs, one variant per combination of textures in use
+    auto phong_variants = make_shared<ShaderPermutations>(
+                TexturedPhongMaterial::featureNames(), [this](const string& defines) {
+        return createProgramAsync(":/shaders/textured_phong.vert", ":/shaders/textured_phong.frag",
+                                  nullptr, defines);
+    });
+
+    // post processing materials, showing the original image until their programs are ready
+    auto addPostMaterial = [this, &orig](const QString& name, const string& fragment) {
+        auto mat = make_shared<PostMaterial>(orig);
+        post_materials_[name] = mat;
+        if(!fragment.empty())
+            createProgramAsync(":/shaders/post.vert", fragment,
+                               [mat](shared_ptr<QOpenGLShaderProgram> p) { mat->setProgram(p); });
+    };
+    addPostMaterial("original", "");
+    addPostMaterial("motion_blur", ":/shaders/motion_blur.frag");
+
+    // motion blur over a number of frames: running sum, its average, or along the velocities
+    addPostMaterial("motion_accumulate", ":/shaders/motion_accumulate.frag");
+    for(auto name : { "motion_resolve", "velocity_blur" }) {
+        auto mat = make_shared<MotionBlurMaterial>(orig);
+        post_materials_[name] = mat;
+        createProgramAsync(":/shaders/post.vert", string(":/shaders/") + name + ".frag",
+                           [mat](shared_ptr<QOpenGLShaderProgram> p) { mat->setProgram(p); });
+    }
+    // simple effects that can be fused into one pass, see PostEffectComposer;
+    // their programs are generated on first use
+    postFallbackProgram_ = orig;
+    using Kind = PostEffectComposer::Kind;
+    postComposer_.addEffect("tone_curve", Kind::Pointwise, ":/shaders/fx_tone_curve.glsl");
+    postComposer_.addEffect("vignette", Kind::Pointwise, ":/shaders/fx_vignette.glsl");
+    postComposer_.addEffect("grayscale", Kind::Pointwise, ":/shaders/fx_grayscale.glsl");
+    postComposer_.addEffect("sharpen", Kind::Neighborhood, ":/shaders/fx_sharpen.glsl");
+
+    velocityMaterial_ = make_shared<VelocityMaterial>(
+                createProgram(":/shaders/velocity.vert", ":/shaders/velocity.frag"));
+
+    // separable blurs: horizontal (_1) and vertical (_2) pass, all four sharing one program
+    using Kernel = SeparableBlurMaterial::Kernel;
+    vector<shared_ptr<SeparableBlurMaterial>> separable = {
+        make_shared<SeparableBlurMaterial>(orig, Kernel::Box, false),
+        make_shared<SeparableBlurMaterial>(orig, Kernel::Box, true),
+        make_shared<SeparableBlurMaterial>(orig, Kernel::Gaussian, false),
+        make_shared<SeparableBlurMaterial>(orig, Kernel::Gaussian, true) };
+    post_materials_["blur_1"] = separable[0];
+    post_materials_["blur_2"] = separable[1];
+    post_materials_["gauss_1"] = separable[2];
+    post_materials_["gauss_2"] = separable[3];
+    createProgramAsync(":/shaders/post.vert", ":/shaders/separable_blur.frag",
+                       [separable](shared_ptr<QOpenGLShaderProgram> p) {
+        for(auto& mat : separable)
+            mat->setProgram(p);
+    });
+
+    // dual filter blur: steps down and back up a pyramid of half-size images
+    for(auto step : { "down", "up" }) {
+        auto mat = make_shared<DualFilterMaterial>(orig);
+        post_materials_[QString("dual_filter_") + step] = mat;
+        createProgramAsync(":/shaders/post.vert", string(":/shaders/dual_filter_") + step + ".frag",
+                           [mat](shared_ptr<QOpenGLShaderProgram> p) { mat->setProgram(p); });
+    }
 
-    // instance of textured Phong material, starting with tex unit 2
-    materials_["red"] = std::make_shared<TexturedPhongMaterial>(phong_prog,2);
+    // instance of textured Phong material, plain Phong until its variant is compiled
+    materials_["red"] = std::make_shared<TexturedPhongMaterial>(phong_variants, fallback_phong);
     materials_["red"]->phong.k_diffuse = QVector3D(0.8f,0.1f,0.1f);
     materials_["red"]->phong.k_ambient = materials_["red"]->phong.k_diffuse * 0.3f;
     materials_["red"]->phong.shininess = 80;
     materials_["red"]->tex.useEnvironmentTexture = true;
-    materials_["red"]->tex.environmentTexture = cubetex;
     materials_["red"]->tex.useDiffuseTexture = true;
+
+    // start compiling the variant now, it overlaps with loading the assets below
+    materials_["red"]->selectProgram();
+
+    // load textures; image decoding runs on the job system, OpenGL upload here
+    QImage stdimg;
+    auto decodeStd = jobs.submit([&stdimg] { stdimg = QImage(":/textures/RTR-ist-super-4-3.png"); });
+    std::shared_ptr<QOpenGLTexture> cubetex = makeCubeMap(":/textures/bridge2048");
+    jobs.wait(decodeStd);
+    std::shared_ptr<QOpenGLTexture> stdtex = std::make_shared<QOpenGLTexture>(stdimg);
+
+    // make sky box material
+    auto skymat = make_shared<SkyBoxMaterial>(sky_prog);
+
+    // sky box object, can draw a skybox around a give camera, not part of the scene
+    skymat->texture = cubetex;
+    skybox_ = make_shared<SkyBox>(skymat, nullptr, nullptr);
+
+    materials_["red"]->tex.environmentTexture = cubetex;
     materials_["red"]->tex.diffuseTexture = stdtex;
 
+    // parameters of materials used for drawing go into the material table
+    materialTable_->add(materials_["red"]);
+
     // copy of the material, for changing values relative to original value
     materials_["red_original"] = std::make_shared<TexturedPhongMaterial>(*materials_["red"]);
     auto std = materials_["red"];
 
-    // post processing materials, using separate tex units 10-12
-    auto orig = createProgram(":/shaders/post.vert",
-                              ":/shaders/original.frag");
-    post_materials_["original"] = make_shared<PostMaterial>(orig, 10);
-
-    auto blur = createProgram(":/shaders/post.vert",
-                              ":/shaders/blur.frag");
-    post_materials_["blur"] = make_shared<PostMaterial>(blur, 11);
-
-    auto gaussA = createProgram(":/shaders/post.vert",
-                                ":/shaders/gauss_9x9_passA.frag");
-    auto gaussB = createProgram(":/shaders/post.vert",
-                                ":/shaders/gauss_9x9_passB.frag");
-    post_materials_["gauss_1"] = make_shared<PostMaterial>(gaussA,11);
-    post_materials_["gauss_2"] = make_shared<PostMaterial>(gaussB,12);
-
-    auto motionBlur = createProgram(":/shaders/post.vert",
-                              ":/shaders/motion_blur.frag");
-    post_materials_["motion_blur"] = make_shared<PostMaterial>(motionBlur, 11);
-
-    // load meshes from .obj files and assign shader programs to them
-    meshes_["Duck"]    = std::make_shared<Mesh>(":/models/duck/duck.obj", std);
-    meshes_["Teapot"]  = std::make_shared<Mesh>(":/models/teapot/teapot.obj", std);
-    //meshes_["Test"]  = std::make_shared<Mesh>(":/models/enemy/1_attackable.obj", std);
-    meshes_["Test"]  = std::make_shared<Mesh>(":/models/player/blk.obj", std);
-    meshes_["1_E_Stance"]  = std::make_shared<Mesh>(":/models/enemy/1_attackable.obj", std);
-    meshes_["2_E_Stance"]  = std::make_shared<Mesh>(":/models/enemy/2_attackable.obj", std);
-    meshes_["3_E_Stance"]  = std::make_shared<Mesh>(":/models/enemy/3_attackable.obj", std);
-    meshes_["4_E_Stance"]  = std::make_shared<Mesh>(":/models/enemy/4_attackable.obj", std);
-    meshes_["P_Attack"]  = std::make_shared<Mesh>(":/models/player/att.obj", std);
-    meshes_["P_Block"]  = std::make_shared<Mesh>(":/models/player/blk.obj", std);
+    // light passes of the deferred pipeline, available once the program is compiled
+    createProgramAsync(":/shaders/deferred_light.vert", ":/shaders/deferred_light.frag",
+                       [this](shared_ptr<QOpenGLShaderProgram> p) {
+        deferredLight_ = make_shared<Mesh>(make_shared<geom::RectXY>(1, 1),
+                                           make_shared<DeferredLightMaterial>(p));
+    });
+
+    // depth pre-pass of the forward pipeline, available once the program is compiled
+    createProgramAsync(":/shaders/depth_prepass.vert", ":/shaders/depth_only.frag",
+                       [this](shared_ptr<QOpenGLShaderProgram> p) {
+        depthPrePassMaterial_ = make_shared<DepthOnlyMaterial>(p);
+    });
+
+    // cached shadow maps, casters are drawn with the depth-only program
+    shadowMaps_ = std::make_unique<ShadowMaps>(make_shared<DepthOnlyMaterial>(depth_prog));
+    casterListBuilder_.frustumCulling = false;
+
+    // bounding box proxy for occlusion queries, drawn without color
+    occlusionProxy_ = std::make_shared<Mesh>(make_shared<geom::Cube>(),
+                                             make_shared<DepthOnlyMaterial>(depth_prog));
+
+    // load meshes from .obj files and assign shader programs to them.
+    // parsing runs in parallel on the job system, buffers are created here.
+    const std::vector<std::pair<QString, std::string>> objFiles = {
+        { "Duck",        ":/models/duck/duck.obj" },
+        { "Teapot",      ":/models/teapot/teapot.obj" },
+        //{ "Test",      ":/models/enemy/1_attackable.obj" },
+        { "Test",        ":/models/player/blk.obj" },
+        { "1_E_Stance",  ":/models/enemy/1_attackable.obj" },
+        { "2_E_Stance",  ":/models/enemy/2_attackable.obj" },
+        { "3_E_Stance",  ":/models/enemy/3_attackable.obj" },
+        { "4_E_Stance",  ":/models/enemy/4_attackable.obj" },
+        { "P_Attack",    ":/models/player/att.obj" },
+        { "P_Block",     ":/models/player/blk.obj" }
+    };
+    std::vector<ObjLoader> objs(objFiles.size());
+    jobs.parallelFor(0, objFiles.size(), 1, [&objFiles, &objs](size_t from, size_t to) {
+        for(size_t i=from; i<to; i++)
+            objs[i] = GeometryOBJ::load(objFiles[i].second);
+    });
+    for(size_t i=0; i<objFiles.size(); i++)
+        meshes_[objFiles[i].first] = std::make_shared<Mesh>(make_shared<GeometryOBJ>(objs[i]), std);
 
     // add meshes of some procedural geometry objects (not loaded from OBJ files)
     meshes_["Cube"]   = std::make_shared<Mesh>(make_shared<geom::Cube>(), std);
@@ -133,24 +251,31 @@ void Scene::makeNodes()
                                                   post_materials_["original"]);
     nodes_["original"]   = createNode(meshes_["original"], false);
 
-    meshes_["blur"]      = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1),
-                                                  post_materials_["blur"]);
-    nodes_["blur"]       = createNode(meshes_["blur"], false);
+    meshes_["blur_1"]    = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), post_materials_["blur_1"]);
+    nodes_ ["blur_1"]    = createNode(meshes_["blur_1"], false);
+    meshes_["blur_2"]    = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), post_materials_["blur_2"]);
+    nodes_ ["blur_2"]    = createNode(meshes_["blur_2"], false);
 
     meshes_["gauss_1"]   = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), post_materials_["gauss_1"]);
     nodes_ ["gauss_1"]   = createNode(meshes_["gauss_1"], false);
     meshes_["gauss_2"]   = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), post_materials_["gauss_2"]);
     nodes_ ["gauss_2"]   = createNode(meshes_["gauss_2"], false);
 
+    meshes_["dual_filter_down"] = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), post_materials_["dual_filter_down"]);
+    nodes_ ["dual_filter_down"] = createNode(meshes_["dual_filter_down"], false);
+    meshes_["dual_filter_up"]   = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), post_materials_["dual_filter_up"]);
+    nodes_ ["dual_filter_up"]   = createNode(meshes_["dual_filter_up"], false);
+
+    for(auto name : { "motion_accumulate", "motion_resolve", "velocity_blur" }) {
+        meshes_[name] = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), post_materials_[name]);
+        nodes_ [name] = createNode(meshes_[name], false);
+    }
+
     meshes_["motion_blur"]      = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1),
                                                   post_materials_["motion_blur"]);
     nodes_["motion_blur"]       = createNode(meshes_["motion_blur"], false);
 
 
-    // initial state of post processing phases
-    nodes_["post_pass_1"] = nodes_["motion_blur"];
-    nodes_["post_pass_2"] = nullptr;
-
     // pack each mesh into a scene node, along with a transform that scales
     // it to standard size [1,1,1]
     nodes_["Cube"]    = createNode(meshes_["Cube"], true);
@@ -270,8 +395,23 @@ void Scene::makeScene()
     nodes_["Light0"] = createNode(nullptr, false);
     nodes_["World"]->children.push_back(nodes_["Light0"]);
     lightNodes_.push_back(nodes_["Light0"]);
+    frameUniforms_->lights.push_back(FrameUniforms::PointLight());
     nodes_["Light0"]->transformation.translate(QVector3D(-0.55f, 0.68f, 4.34f)); // above camera
 
+    // torches: small colored lights circling around the model, fixed seed
+    mt19937 random(4711);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    for(int i=0; i<256; i++) {
+        Torch t;
+        t.center = QVector3D(4*unit(random) - 2, 3*unit(random) - 1.5f, 4*unit(random) - 2);
+        t.radius = 0.2f + 0.6f * unit(random);
+        t.speed = (unit(random) < 0.5f? -1 : 1) * (0.3f + unit(random));
+        t.phase = 6.2831853f * unit(random);
+        t.range = 0.3f + 0.5f * unit(random);
+        t.intensity = 0.6f * QVector3D(unit(random), unit(random), unit(random));
+        torches_.push_back(t);
+    }
+
 }
 
 
@@ -289,85 +429,155 @@ void Scene::draw()
     millisec_since_last_draw = chrono::duration_cast<chrono::milliseconds>(current - lastDrawTime_);
     lastDrawTime_ = current;
 
-    // set time uniform in animated shader(s)
-    float t = millisec_since_first_draw.count() / 1000.0f;
-    for(auto mat : materials_)
-        mat.second->time = t;
+    // start collecting statistics for this frame
+    RenderStats::current().reset();
 
-    // create an FBO to render the scene into
-    if(!new_frame) {
+    // Qt may have changed OpenGL state between frames
+    GLState::current().invalidate();
 
-        // for high-res Retina displays
-        auto pixel_scale = parent_->devicePixelRatio();
+    // delete the queries of nodes that stopped using them
+    retiredQueries_.clear();
 
-        // what kind of FBO do we want?
-        auto fbo_format = QOpenGLFramebufferObjectFormat();
-        fbo_format.setAttachment(QOpenGLFramebufferObject::Depth);
-
-        // create some FBOs for post processing
-        fbo1_ = std::make_shared<QOpenGLFramebufferObject>(parent_->width()*pixel_scale,
-                                                           parent_->height()*pixel_scale,
-                                                           fbo_format);
-        fbo2_ = std::make_shared<QOpenGLFramebufferObject>(parent_->width()*pixel_scale,
-                                                           parent_->height()*pixel_scale,
-                                                           fbo_format);
-        new_frame = std::make_shared<QOpenGLFramebufferObject>(parent_->width()*pixel_scale,
-                                                          parent_->height()*pixel_scale,
-                                                          fbo_format);
+    // hand over programs compiled in the background, replacing fallbacks.
+    // requests keep arriving after startup (variants, fused post effects),
+    // so poll every frame; the flag only reports the startup set once.
+    auto programsLeft = programCompiler_->poll();
+    if(programsPending_ && programsLeft == 0) {
+        programsPending_ = false;
+        cout << "all shader programs ready after "
+             << chrono::duration<double, milli>(clock_.now() - firstDrawTime_).count()
+             << " ms" << endl;
+    }
 
-        qDebug() << "Creating FBOs with size" << new_frame->size();
+    // deliver buffer contents read back in earlier frames
+    if(readback_)
+        readback_->poll();
+
+    // set time uniform in animated shader(s), uploaded with the per-frame data
+    frameUniforms_->time = millisec_since_first_draw.count() / 1000.0f;
+
+    // size to render at: follow the window once resizing has settled
+    auto pixel_scale = parent_->devicePixelRatio();
+    QSize window(parent_->width()*pixel_scale, parent_->height()*pixel_scale);
+    if(renderSize_ != window) {
+        auto sinceResize = chrono::duration_cast<chrono::milliseconds>(current - lastResize_);
+        if(renderSize_.isEmpty() || sinceResize.count() >= resizeDelayMs_) {
+            renderSize_ = window;
+            releasePostHistory_();
+            renderTargets_.clear();
+        }
     }
 
-    // draw the actual scene into new_frame
+    // draw the actual scene into an FBO with depth, at the render size
+    new_frame = renderTargets_.acquire(renderSize_, RenderTargetPool::Format::ColorDepth);
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
     new_frame->bind();
+    glViewport(0, 0, renderSize_.width(), renderSize_.height());
     draw_scene_();
     new_frame->release();
-    auto fbo_to_be_rendered = new_frame;
-    auto node_to_be_rendered = nodes_["post_pass_1"];
 
-    if(last_FBO_rendered_was_one){
-        fbo2_->bind();
-    }else{
-        fbo1_->bind();
-    }
-    if(last_FBO_rendered_was_one){
-        post_draw_full_(*fbo_to_be_rendered, *fbo1_, *node_to_be_rendered);
-    }else{
-        post_draw_full_(*fbo_to_be_rendered, *fbo2_, *node_to_be_rendered);
+    // per-pixel motion, only if an effect needs it
+    velocity_ = nullptr;
+    if(find(postChain_.begin(), postChain_.end(), QString("velocity_blur")) != postChain_.end()) {
+        velocity_ = renderTargets_.acquire(renderSize_, RenderTargetPool::Format::HalfFloatDepth);
+        velocity_->bind();
+        draw_velocity_();
+        velocity_->release();
+    } else {
+        previousModel_.clear();
     }
-    if(last_FBO_rendered_was_one){
-        fbo2_->release();
-    }else{
-        fbo1_->release();
+    glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+
+    // extract FBO images and display them in the UI, every 20 frames
+    static size_t framecount=20-2; // initially will render twice
+    bool inspect = show_FBOs_ && ++framecount % 20 == 0;
+
+    // post processing: the effect chain, then the result to the screen
+    const QSize size = new_frame->size();
+    RenderGraph graph(renderTargets_);
+    auto screen = graph.screen(size);
+    auto scene = graph.importTexture("scene", new_frame->texture(), size);
+    auto result = scene;
+
+    // the last effect draws to the screen directly (scaled while resizing),
+    // unless the result is needed elsewhere
+    // runs of simple effects become one pass each (or one pass per effect without fusion)
+    bool direct = !split_display_ && !inspect;
+    vector<string> chain;
+    for(const auto& effect : postChain_)
+        chain.push_back(effect.toStdString());
+    for(size_t i=0; i<chain.size(); ) {
+        size_t n = postComposer_.groupLength(chain, i);
+        if(!postFusion_)
+            n = min(n, size_t(1));
+        size_t next = i + max(n, size_t(1));
+        auto output = next == chain.size() && direct? screen : -1;
+        if(n > 0)
+            result = addFusedEffects_(graph, vector<string>(chain.begin()+i, chain.begin()+next),
+                                      result, output);
+        else
+            result = addPostEffect_(graph, postChain_[i], result, output);
+        i = next;
     }
 
-    // final rendering pass, into visible framebuffer (object)
     if(split_display_) {
-        if(last_FBO_rendered_was_one){
-            post_draw_split_(*new_frame, *nodes_["original"],
-                             *fbo_to_be_rendered, *fbo1_, *node_to_be_rendered);
-        }else{
-            post_draw_split_(*new_frame, *nodes_["original"],
-                             *fbo_to_be_rendered, *fbo2_, *node_to_be_rendered);
-        }
-    } else {
-        if(last_FBO_rendered_was_one){
-            post_draw_full_(*fbo_to_be_rendered, *fbo1_, *node_to_be_rendered);
-        }else{
-            post_draw_full_(*fbo_to_be_rendered, *fbo2_, *node_to_be_rendered);
-        }
+        // left half: original scene, right half: post processing result
+        graph.addPass("split display", {scene, result}, screen, [this](const RenderGraph::Pass& p) {
+            auto& state = GLState::current();
+            int w = p.outputSize().width(), h = p.outputSize().height();
+            state.enable(GL_SCISSOR_TEST);
+            glScissor(0, 0, w/2, h);
+            post_draw_(*nodes_["original"], p.texture(0), p.inputSize(0));
+            glScissor(w/2, 0, w-w/2, h);
+            post_draw_(*nodes_["original"], p.texture(1), p.inputSize(1));
+            state.disable(GL_SCISSOR_TEST);
+        });
+    } else if(result != screen) {
+        graph.addPass("present", {result}, screen, [this](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_["original"], p.texture(0), p.inputSize(0));
+        });
     }
 
-    // extract FBI image and display in the UI, every 20 frames
-    static size_t framecount=20-2; // initially will render twice
-    if(show_FBOs_) {
-        if(++framecount % 20 == 0) {
-            emit displayBufferContents(0, "rendered scene", new_frame->toImage());
-            emit displayBufferContents(1, "fbo 1", fbo1_->toImage());
+    if(inspect) {
+        if(!postInspected_ || postInspected_->size() != size) {
+            postInspected_ = make_shared<QOpenGLFramebufferObject>(size, QOpenGLFramebufferObject::NoAttachment,
+                                                                   GLenum(GL_TEXTURE_2D), GLenum(GL_RGBA8));
+            GLState::current().invalidate();
         }
+        auto copy = graph.importTarget("inspected", postInspected_);
+        graph.addPass("inspect", {result}, copy, [this](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_["original"], p.texture(0), p.inputSize(0));
+        });
+    }
+
+    graph.execute();
+
+    // read back without waiting; the images are emitted by a later frame.
+    // requested before the scene image goes back to the pool.
+    if(inspect) {
+        if(!readback_)
+            readback_ = make_unique<AsyncReadback>(
+                        [this](unsigned int id, QString label, const QImage& image) {
+                emit displayBufferContents(id, label, image);
+            });
+        readback_->request(new_frame->handle(), new_frame->size(), 0, "rendered scene");
+        readback_->request(postInspected_->handle(), postInspected_->size(), 1, "post processing");
     }
 
-    last_FBO_rendered_was_one = !last_FBO_rendered_was_one;
+    renderTargets_.release(new_frame);
+    if(velocity_)
+        renderTargets_.release(velocity_);
+    renderTargets_.endFrame();
+
+    // print statistics of this frame, every 60 frames
+    static size_t statsframecount = 0;
+    if(show_stats_ && ++statsframecount % 60 == 0) {
+        qDebug() << RenderStats::current();
+        qDebug().nospace() << "forward passes GPU time: "
+                           << forwardTimers_[1]->milliseconds() << " ms with depth pre-pass, "
+                           << forwardTimers_[0]->milliseconds() << " ms without";
+    }
 
 }
 
@@ -382,131 +592,583 @@ void Scene::draw_scene_()
     auto camToWorld = nodes_["World"]->toParentTransform(nodes_["Camera"]);
     auto viewMatrix = camToWorld.inverted();
     Camera camera(viewMatrix, projectionMatrix);
+    viewProjection_ = projectionMatrix * viewMatrix;
+
+    // switch materials to the program variants for the requested pipeline
+    // (may compile a variant); true if all of them are ready. Sort keys use the program.
+    auto selectPrograms = [this](bool gbuffer, bool clustered) {
+        bool ready = true;
+        for(auto& mat : materials_) {
+            mat.second->writeGBuffer = gbuffer;
+            mat.second->clusteredLights = clustered;
+            mat.second->lightClusters = lightClusters_.get();
+            mat.second->shadowMaps = shadows_? shadowMaps_.get() : nullptr;
+            mat.second->selectProgram();
+            ready = ready && mat.second->programUpToDate();
+        }
+        return ready;
+    };
+
+    // clustered lighting takes precedence over deferred shading; either one
+    // is only used once all of its programs are compiled, plain forward until then
+    bool clustered = clusteredLighting_ && selectPrograms(false, true);
+    bool deferred = !clustered && deferredShading_ && deferredLight_ &&
+                    selectPrograms(true, false);
+    if(!clustered && !deferred)
+        selectPrograms(false, false);
+
+    // CPU frame preparation: traversal, culling and sorting, no GL calls yet
+    auto prepStart = clock_.now();
+    drawListBuilder_.build(*nodes_["World"], camera, drawList_);
+    RenderStats::current().prepMilliseconds +=
+            chrono::duration<double, milli>(clock_.now() - prepStart).count();
+
+    // per-frame data: camera and light positions, written once for all programs
+    for(unsigned int i=0; i<lightNodes_.size(); i++) {
+        QMatrix4x4 lightToWorld = nodes_["World"]->toParentTransform(lightNodes_[i]);
+        frameUniforms_->lights[i].position_WC = lightToWorld * QVector4D(0,0,0,1);
+    }
+    frameUniforms_->upload(camera);
+    drawUniforms_->upload(camera, drawList_);
+    materialTable_->update();
+
+    // clustered lighting: the frame's lights plus the torches
+    if(clustered) {
+        auto& lights = lightClusters_->lights;
+        lights.clear();
+        for(const auto& l : frameUniforms_->lights)
+            lights.push_back({ l.position_WC.toVector3D(), l.range, l.color * l.intensity });
+        for(const auto& t : torches_) {
+            float angle = t.phase + t.speed * frameUniforms_->time;
+            QVector3D offset(t.radius * cos(angle), 0.0f, t.radius * sin(angle));
+            lights.push_back({ t.center + offset, t.range, t.intensity });
+        }
+        lightClusters_->update(camera);
+    }
+
+    // shadow maps of the frame's lights, only re-rendered where something has changed.
+    // all meshes may cast shadows, visible or not.
+    if(shadows_ && !deferred) {
+        casterListBuilder_.build(*nodes_["World"], camera, casterList_);
+        vector<ShadowMaps::Light> lights;
+        for(size_t i=0; i<frameUniforms_->lights.size(); i++) {
+            const auto& l = frameUniforms_->lights[i];
+            lights.push_back({ int(i), l.position_WC.toVector3D(), l.range });
+        }
+        shadowMaps_->update(lights, casterList_);
+    }
+
+    if(deferred) {
+        draw_deferred_(camera);
+        drawUniforms_->endFrame();
+        return;
+    }
+
+    auto& state = GLState::current();
+
+    // GPU time of the forward passes, separately with and without pre-pass
+    bool prePass = depthPrePass_ && depthPrePassMaterial_;
+    auto& timer = *forwardTimers_[prePass];
+    timer.begin();
 
     // clear buffer
     glClearColor(bgcolor_[0], bgcolor_[1], bgcolor_[2], 1.0);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // initial pass: draw skybox, does not modify depth buffer
-    glDisable(GL_BLEND);
+    state.disable(GL_BLEND);
     if(drawSkyBox_)
         skybox_->draw(camera);
 
     // first light pass: standard depth test, no blending
-    glDepthFunc(GL_LESS);
-    glEnable(GL_DEPTH_TEST);
-    glDisable(GL_BLEND);
-    glDisable(GL_CULL_FACE);
+    state.depthFunc(GL_LESS);
+    state.enable(GL_DEPTH_TEST);
+    state.disable(GL_BLEND);
+    state.disable(GL_CULL_FACE);
+
+    // depth pre-pass: depth only, with a trivial program. All light passes then
+    // test with GL_EQUAL and do not write depth, so each pixel is shaded at most
+    // once per light instead of once per overlapping surface.
+    if(prePass) {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        drawList_.submitDepth(camera, *depthPrePassMaterial_, drawUniforms_.get());
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        state.depthFunc(GL_EQUAL);
+        glDepthMask(GL_FALSE);
+    }
 
-    // draw one pass for each light
-    for(unsigned int i=0; i<lightNodes_.size(); i++) {
+    if(singlePassLighting_ || clustered) {
 
-        // determine current light position and set it in all materials
-        QMatrix4x4 lightToWorld = nodes_["World"]->toParentTransform(lightNodes_[i]);
-        for(auto mat : materials_) {
-            auto phong = mat.second; // mat is of type (key, value)
-            phong->lights[i].position_WC = lightToWorld * QVector3D(0,0,0);
+        // single pass: the shaders loop over all lights in the FrameData block,
+        // or over the lights of their cluster
+        drawList_.submit(camera, Material::allLights, drawUniforms_.get());
+
+    } else {
+
+        // multi-pass: draw one pass for each light. Pass 0 also adds the ambient
+        // part and lays down the depth, so it always draws everything; later
+        // passes only touch the meshes and the screen area in the light's range.
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        for(unsigned int i=0; i<lightNodes_.size(); i++) {
+
+            // draw light pass i
+            if(i == 0) {
+                drawList_.submit(camera, i, drawUniforms_.get());
+            } else {
+                const auto& light = frameUniforms_->lights[i];
+                LightBounds bounds(light.position_WC.toVector3D(), light.range);
+                GLint rect[4];
+                if(bounds.scissorRect(camera, viewport, rect)) {
+                    glScissor(rect[0], rect[1], rect[2], rect[3]);
+                    drawList_.submit(camera, i, drawUniforms_.get(), &bounds);
+                } else {
+                    RenderStats::current().lightPassesSkipped++;
+                }
+            }
+
+            // settings for i>0 (add light contributions using alpha blending)
+            state.enable(GL_BLEND);
+            state.blendFunc(GL_ONE,GL_ONE);
+            state.depthFunc(GL_EQUAL);
+            state.enable(GL_SCISSOR_TEST);
         }
+        state.disable(GL_SCISSOR_TEST);
+    }
 
-        // draw light pass i
-        nodes_["World"]->draw(camera, i);
+    if(prePass)
+        glDepthMask(GL_TRUE);
+    timer.end();
 
-        // settings for i>0 (add light contributions using alpha blending)
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_ONE,GL_ONE);
-        glDepthFunc(GL_EQUAL);
+    // this frame's draw data region can be reused once these draws are done
+    drawUniforms_->endFrame();
+}
+
+void Scene::draw_deferred_(const Camera &camera)
+{
+    auto& state = GLState::current();
+
+    // geometry pass: surface attributes into the G-buffer, same size as the lit frame
+    if(!gbuffer_)
+        gbuffer_ = std::make_unique<GBuffer>();
+    gbuffer_->resize(new_frame->size());
+    gbuffer_->bind();
+
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    state.depthFunc(GL_LESS);
+    state.enable(GL_DEPTH_TEST);
+    state.disable(GL_BLEND);
+    state.disable(GL_CULL_FACE);
+    drawList_.submit(camera, Material::allLights, drawUniforms_.get());
+    gbuffer_->release();
+
+    // light passes into new_frame, which post processing reads as usual.
+    // the scene's depth is copied over, so lights only touch covered pixels.
+    new_frame->bind();
+    gbuffer_->blitDepth(*new_frame);
+    glClearColor(bgcolor_[0], bgcolor_[1], bgcolor_[2], 1.0);
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // background: skybox, does not modify depth buffer
+    state.disable(GL_BLEND);
+    if(drawSkyBox_)
+        skybox_->draw(camera);
+
+    /*
+     * one light volume per light, drawn in screen space at the far plane
+     * with GL_GREATER: background pixels are rejected by the depth test,
+     * so the cost depends on the lit pixels, not on the scene geometry.
+     * Pass 0 replaces the background with the emission and covers the
+     * viewport; later passes add, scissored to the screen area in the
+     * light's range.
+     */
+    static_cast<DeferredLightMaterial&>(*deferredLight_->material()).gbuffer = gbuffer_.get();
+    state.enable(GL_DEPTH_TEST);
+    state.depthFunc(GL_GREATER);
+    glDepthMask(GL_FALSE);
+
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    unsigned int passes = max(unsigned(lightNodes_.size()), 1u);
+    for(unsigned int i=0; i<passes; i++) {
+        if(i > 0) {
+            const auto& light = frameUniforms_->lights[i];
+            GLint rect[4];
+            if(!LightBounds(light.position_WC.toVector3D(), light.range)
+                    .scissorRect(camera, viewport, rect)) {
+                RenderStats::current().lightPassesSkipped++;
+                continue;
+            }
+            glScissor(rect[0], rect[1], rect[2], rect[3]);
+        }
+        deferredLight_->draw(i);
+        state.enable(GL_BLEND);
+        state.blendFunc(GL_ONE,GL_ONE);
+        state.enable(GL_SCISSOR_TEST);
     }
+
+    state.disable(GL_SCISSOR_TEST);
+    glDepthMask(GL_TRUE);
+    state.depthFunc(GL_LESS);
 }
 
-void Scene::post_draw_full_(QOpenGLFramebufferObject &fbo, QOpenGLFramebufferObject &fbo2, Node& node)
+void Scene::post_draw_(Node &node, GLuint texture, const QSize &size, GLuint texture2,
+                       bool additive)
 {
     // set up camera for post processing
     QMatrix4x4 view, projection;
     projection.ortho(-1,1,-1,1,-1,1);
     Camera camera(view, projection);
 
-    // width and height of FBO / viewport
-    int w = fbo.size().width();
-    int h = fbo.size().height();
-
-    // use the texture from the FBO during rendering
+    // use the given texture(s) during rendering
     for(auto mat : post_materials_) {
-        mat.second->post_texture_id = fbo.texture();
-        mat.second->post_texture_id2 = fbo2.texture();
-        mat.second->image_size = QSize(w,h);
+        mat.second->post_texture_id = GLint(texture);
+        mat.second->post_texture_id2 = GLint(texture2);
+        mat.second->image_size = size;
     }
 
     // initial state for drawing full-viewport rectangles
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_BLEND);
+    auto& state = GLState::current();
+    state.disable(GL_DEPTH_TEST);
+    state.disable(GL_CULL_FACE);
+    if(additive) {
+        state.enable(GL_BLEND);
+        state.blendFunc(GL_ONE, GL_ONE);
+    } else {
+        state.disable(GL_BLEND);
+    }
 
     // draw single full screen rectangle with post processing material
     node.draw(camera);
 }
 
-void Scene::post_draw_split_(QOpenGLFramebufferObject &fbo1, Node& node1,
-                             QOpenGLFramebufferObject &fbo2, QOpenGLFramebufferObject &fbo3, Node& node2)
+void Scene::draw_velocity_()
 {
-    // set up camera for post processing
-    QMatrix4x4 view, projection;
-    projection.ortho(-1,1,-1,1,-1,1);
-    Camera camera(view, projection);
+    auto& state = GLState::current();
+    state.enable(GL_DEPTH_TEST);
+    state.depthFunc(GL_LESS);
+    state.disable(GL_BLEND);
+    glDepthMask(GL_TRUE);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-    // width and height of FBO / viewport
-    int w = fbo1.size().width();
-    int h = fbo1.size().height();
-    int halfw = w/2;
+    // meshes that were not drawn last frame have not moved
+    bool first = previousModel_.empty();
+    const QMatrix4x4& previousViewProjection = first? viewProjection_ : previousViewProjection_;
+
+    // background: camera motion only. A full-screen rectangle whose points are
+    // taken to the far plane and reprojected with last frame's view-projection.
+    // Drawn without depth, the meshes below overwrite it where they cover it.
+    QMatrix4x4 farPlane;
+    farPlane.translate(0, 0, 1);
+    velocityMaterial_->modelViewProjection.setToIdentity();
+    velocityMaterial_->previousModelViewProjection =
+            previousViewProjection * viewProjection_.inverted() * farPlane;
+    bool cull = state.isEnabled(GL_CULL_FACE);
+    state.disable(GL_DEPTH_TEST);
+    state.disable(GL_CULL_FACE);
+    meshes_["original"]->draw(*velocityMaterial_);
+    state.set(GL_CULL_FACE, cull);
+    state.enable(GL_DEPTH_TEST);
+    unordered_map<const Node*, QMatrix4x4> model;
+    for(const auto& item : drawList_.items) {
+        auto previous = previousModel_.find(item.node);
+        velocityMaterial_->modelViewProjection = viewProjection_ * item.modelMatrix;
+        velocityMaterial_->previousModelViewProjection = previousViewProjection *
+                (previous != previousModel_.end()? previous->second : item.modelMatrix);
+        item.mesh->draw(*velocityMaterial_);
+        model[item.node] = item.modelMatrix;
+    }
 
-    // initial state for drawing full-viewport rectangles
-    glDisable(GL_DEPTH_TEST);
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_BLEND);
+    previousModel_.swap(model);
+    previousViewProjection_ = viewProjection_;
+}
 
-    // left half of node1
+RenderGraph::Handle Scene::addFusedEffects_(RenderGraph &graph, const vector<string> &group,
+                                            RenderGraph::Handle input, RenderGraph::Handle output)
+{
+    // material and node per group; showing the original image until the program is built
+    const string key = PostEffectComposer::key(group);
+    const QString name = QString::fromStdString("fused " + key);
+    if(!fusedPrograms_.count(key)) {
+        fusedPrograms_[key] = createGeneratedProgramAsync(":/shaders/post.vert",
+                                                          postComposer_.fragmentSource(group));
+        auto mat = make_shared<PostMaterial>(postFallbackProgram_);
+        post_materials_[name] = mat;
+        meshes_[name] = std::make_shared<Mesh>(make_shared<geom::RectXY>(1, 1), mat);
+        nodes_[name] = createNode(meshes_[name], false);
+    }
+    auto program = fusedPrograms_[key]->program();
+    if(program && &post_materials_[name]->program() != program.get())
+        post_materials_[name]->setProgram(program);
+
+    auto result = output >= 0? output : graph.create(key, new_frame->size());
+    graph.addPass(key, {input}, result, [this, name](const RenderGraph::Pass& p) {
+        post_draw_(*nodes_[name], p.texture(0), p.inputSize(0));
+    });
+    return result;
+}
 
-    // use texture from fbo1 during rendering
-    for(auto mat : post_materials_) {
-        mat.second->post_texture_id = fbo1.texture();
-        mat.second->image_size = QSize(w,h);
+void Scene::releasePostHistory_()
+{
+    for(auto& h : postHistory_) {
+        if(h)
+            renderTargets_.release(h);
+        h = nullptr;
     }
-    glEnable(GL_SCISSOR_TEST);
-    glScissor(0,0,halfw,h);
-    node1.draw(camera);
 
-    // right half of node2
+    for(auto& t : accumulationRing_)
+        renderTargets_.release(t);
+    accumulationRing_.clear();
+    if(accumulationSum_)
+        renderTargets_.release(accumulationSum_);
+    accumulationSum_ = nullptr;
+    accumulationIndex_ = 0;
+    accumulated_ = 0;
+}
 
-    // use texture from fbo2 during rendering
-    for(auto mat : post_materials_) {
-        mat.second->post_texture_id = fbo2.texture();
-        mat.second->post_texture_id = fbo3.texture();
-        mat.second->image_size = QSize(w,h);
+RenderGraph::Handle Scene::addPostEffect_(RenderGraph &graph, const QString &effect,
+                                          RenderGraph::Handle input, RenderGraph::Handle output)
+{
+    const QSize size = new_frame->size();
+    auto target = [&](const string& name) {
+        return output >= 0? output : graph.create(name, size);
+    };
+
+    // separable box / Gaussian blur: horizontal pass into an intermediate image, then vertical
+    if(effect == "blur" || effect == "gauss") {
+        const string name = effect.toStdString();
+        auto horizontal = graph.create(name + " horizontal", size);
+        graph.addPass(name + "_1", {input}, horizontal, [this, effect](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_[effect + "_1"], p.texture(0), p.inputSize(0));
+        });
+        auto result = target(name);
+        graph.addPass(name + "_2", {horizontal}, result, [this, effect](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_[effect + "_2"], p.texture(0), p.inputSize(0));
+        });
+        return result;
     }
 
-    glScissor(halfw,0,w-halfw,h);
-    node2.draw(camera);
-    glDisable(GL_SCISSOR_TEST);
+    // dual filter blur: halve the size per level with small kernels, then back up.
+    // The radius doubles per level, the cost stays below 4/3 of the first step.
+    if(effect == "dual_filter") {
+        auto down = [this](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_["dual_filter_down"], p.texture(0), p.inputSize(0));
+        };
+        auto up = [this](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_["dual_filter_up"], p.texture(0), p.inputSize(0));
+        };
+        auto& mat = static_cast<DualFilterMaterial&>(*post_materials_["dual_filter_down"]);
+        vector<RenderGraph::Handle> level = { input };
+        QSize s = size;
+        for(int i=1; i<=mat.levels() && s.width() > 1 && s.height() > 1; i++) {
+            s = QSize(max(s.width()/2, 1), max(s.height()/2, 1));
+            level.push_back(graph.create("dual filter down " + to_string(i), s));
+            graph.addPass("dual_filter_down", {level[i-1]}, level[i], down);
+        }
+        auto result = level.back();
+        for(int i=int(level.size())-2; i>=0; i--) {
+            auto next = i > 0? graph.create("dual filter up " + to_string(i), graph.size(level[i]))
+                             : target("dual filter");
+            graph.addPass("dual_filter_up", {result}, next, up);
+            result = next;
+        }
+        return result;
+    }
+
+    // accumulated motion blur: average of the last frames, in three passes whatever their number.
+    // The sum is updated in place (additive blending), then the newest frame replaces the oldest.
+    // It counts 8 bit steps of the RGBA8 ring, so what is added is exactly what is later removed.
+    if(effect == "motion_accumulate") {
+        if(accumulationRing_.empty()) {
+            accumulationSum_ = renderTargets_.acquire(size, RenderTargetPool::Format::Float);
+            for(int i=0; i<motionBlurFrames_; i++)
+                accumulationRing_.push_back(renderTargets_.acquire(size));
+            for(auto& t : accumulationRing_) {
+                t->bind();
+                glClearColor(0, 0, 0, 0);
+                glClear(GL_COLOR_BUFFER_BIT);
+            }
+            accumulationSum_->bind();
+            glClear(GL_COLOR_BUFFER_BIT);
+            accumulationSum_->release();
+        }
+
+        auto& oldest = accumulationRing_[accumulationIndex_];
+        accumulationIndex_ = (accumulationIndex_ + 1) % accumulationRing_.size();
+        accumulated_ = min(accumulated_ + 1, motionBlurFrames_);
+
+        auto leaving = graph.importTexture("oldest frame", oldest->texture(), size);
+        auto sum = graph.importTarget("frame sum", accumulationSum_);
+        graph.addPass("motion_accumulate", {input, leaving}, sum, [this](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_["motion_accumulate"], p.texture(0), p.inputSize(0), p.texture(1), true);
+        });
+        auto ring = graph.importTarget("newest frame", oldest);
+        graph.addPass("motion_store", {input}, ring, [this](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_["original"], p.texture(0), p.inputSize(0));
+        });
+
+        auto result = target("accumulated motion blur");
+        graph.addPass("motion_resolve", {sum}, result, [this](const RenderGraph::Pass& p) {
+            static_cast<MotionBlurMaterial&>(*post_materials_["motion_resolve"]).frames = accumulated_;
+            post_draw_(*nodes_["motion_resolve"], p.texture(0), p.inputSize(0));
+        });
+        return result;
+    }
+
+    // velocity motion blur: one pass, samples along each pixel's motion
+    if(effect == "velocity_blur") {
+        auto velocity = graph.importTexture("velocity", velocity_->texture(), size);
+        auto result = target("velocity motion blur");
+        graph.addPass("velocity_blur", {input, velocity}, result, [this](const RenderGraph::Pass& p) {
+            static_cast<MotionBlurMaterial&>(*post_materials_["velocity_blur"]).frames = motionBlurFrames_;
+            post_draw_(*nodes_["velocity_blur"], p.texture(0), p.inputSize(0), p.texture(1));
+        });
+        return result;
+    }
+
+    // motion blur blends with its own result of the last frame, kept across frames
+    if(effect == "motion_blur") {
+        // half float, so the feedback does not band
+        for(auto& h : postHistory_) {
+            if(!h) {
+                h = renderTargets_.acquire(size, RenderTargetPool::Format::HalfFloat);
+                h->bind();
+                glClear(GL_COLOR_BUFFER_BIT);
+                h->release();
+            }
+        }
+        auto& previous = postHistory_[postHistoryIndex_];
+        postHistoryIndex_ = 1 - postHistoryIndex_;
+        auto history = graph.importTexture("motion blur history", previous->texture(), size);
+        auto result = graph.importTarget("motion blur", postHistory_[postHistoryIndex_]);
+        graph.addPass("motion_blur", {input, history}, result, [this](const RenderGraph::Pass& p) {
+            post_draw_(*nodes_["motion_blur"], p.texture(0), p.inputSize(0), p.texture(1));
+        });
+        return result;
+    }
+
+    // single-pass filters
+    if(!nodes_.count(effect))
+        qFatal("Scene: unknown post processing effect");
+    auto result = target(effect.toStdString());
+    graph.addPass(effect.toStdString(), {input}, result, [this, effect](const RenderGraph::Pass& p) {
+        post_draw_(*nodes_[effect], p.texture(0), p.inputSize(0));
+    });
+    return result;
 }
 
-// helper to load shaders and create programs
+namespace {
+
+/*
+ * link a program with the shaders added, bind attributes and uniform blocks;
+ * returns nullptr (and logs why) on failure.
+ */
 shared_ptr<QOpenGLShaderProgram>
-Scene::createProgram(const string& vertex, const string& fragment, const string& geom)
+linkProgram(shared_ptr<QOpenGLShaderProgram> p, bool ok, const string& name)
 {
-    auto p = make_shared<QOpenGLShaderProgram>();
-    if(!p->addShaderFromSourceFile(QOpenGLShader::Vertex, vertex.c_str()))
-        qFatal("could not add vertex shader");
-    if(!p->addShaderFromSourceFile(QOpenGLShader::Fragment, fragment.c_str()))
-        qFatal("could not add fragment shader");
-    if(!geom.empty()) {
-        if(!p->addShaderFromSourceFile(QOpenGLShader::Geometry, geom.c_str()))
-            qFatal("could not add geometry shader");
+    // same attribute locations in all programs, so VAOs do not depend on the program.
+    // cached binaries keep the locations they were linked with, so these never change.
+    GeometryBuffers::bindAttributeLocations(*p);
+    if(!ok || !p->link()) {
+        qWarning() << "could not build shader program" << name.c_str() << p->log();
+        return nullptr;
     }
-    if(!p->link())
-        qFatal("could not link shader program");
+
+    // connect the program to the shared uniform buffers
+    FrameUniforms::bindProgram(*p);
+    DrawUniforms::bindProgram(*p);
+    MaterialTable::bindProgram(*p);
 
     return p;
 }
 
+/*
+ * load shaders and link a program; returns nullptr (and logs why) on failure.
+ * Only needs a current context, so it can run on the compiler's worker thread.
+ */
+shared_ptr<QOpenGLShaderProgram>
+buildProgram(const string& vertex, const string& fragment, const string& geom,
+             const string& defines)
+{
+    /*
+     * read a shader file, and insert the defines right after the #version line.
+     * Cacheable shaders are only compiled if link() does not find a program
+     * binary in Qt's disk cache. The cache key is a hash of all sources
+     * (including the defines) plus GL vendor, renderer and version; binaries
+     * rejected by the driver are dropped and the sources are compiled instead.
+     */
+    auto addShader = [&defines](QOpenGLShaderProgram& prog, QOpenGLShader::ShaderType type,
+                                const string& filename) {
+        if(defines.empty())
+            return prog.addCacheableShaderFromSourceFile(type, filename.c_str());
+
+        QFile file(filename.c_str());
+        if(!file.open(QIODevice::ReadOnly))
+            return false;
+        QByteArray source = file.readAll();
+        int pos = source.startsWith("#version")? source.indexOf('\n') + 1 : 0;
+        source.insert(pos, QByteArray(defines.c_str()));
+        return prog.addCacheableShaderFromSourceCode(type, source);
+    };
+
+    auto p = make_shared<QOpenGLShaderProgram>();
+    bool ok = addShader(*p, QOpenGLShader::Vertex, vertex) &&
+              addShader(*p, QOpenGLShader::Fragment, fragment) &&
+              (geom.empty() || addShader(*p, QOpenGLShader::Geometry, geom));
+    return linkProgram(p, ok, fragment);
+}
+
+// same, with the fragment shader given as source code
+shared_ptr<QOpenGLShaderProgram>
+buildGeneratedProgram(const string& vertex, const string& fragmentSource)
+{
+    auto p = make_shared<QOpenGLShaderProgram>();
+    bool ok = p->addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, vertex.c_str()) &&
+              p->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fragmentSource.c_str());
+    return linkProgram(p, ok, "(generated)");
+}
+
+} // namespace
+
+// helper to load shaders and create programs, blocks until linked
+shared_ptr<QOpenGLShaderProgram>
+Scene::createProgram(const string& vertex, const string& fragment, const string& geom,
+                     const string& defines)
+{
+    auto start = clock_.now();
+
+    auto p = buildProgram(vertex, fragment, geom, defines);
+    if(!p)
+        qFatal("could not create shader program");
+
+    programsCreated_++;
+    programMilliseconds_ += chrono::duration<double, milli>(clock_.now() - start).count();
+
+    return p;
+}
+
+// helper to compile a program in the background, see ProgramCompiler
+shared_ptr<ProgramCompiler::Request>
+Scene::createProgramAsync(const string& vertex, const string& fragment,
+                          ProgramCompiler::Ready ready, const string& defines)
+{
+    return programCompiler_->submit([vertex, fragment, defines] {
+        return buildProgram(vertex, fragment, "", defines);
+    }, ready);
+}
+
+// helper to compile a generated program in the background
+shared_ptr<ProgramCompiler::Request>
+Scene::createGeneratedProgramAsync(const string& vertex, const string& fragmentSource)
+{
+    return programCompiler_->submit([vertex, fragmentSource] {
+        return buildGeneratedProgram(vertex, fragmentSource);
+    });
+}
+
 // helper to make a node from a mesh, and
 // scale the mesh to standard size 1 of desired
 shared_ptr<Node>
@@ -564,8 +1226,7 @@ void Scene::setLightIntensity(size_t i, float v)
 {
     if(i>=lightNodes_.size())
         return;
-    for(auto mat : materials_)
-        mat.second->lights[i].intensity = v; update();
+    frameUniforms_->lights[i].intensity = v; update();
 }
 void Scene::setAmbientScale(float v)
 {
@@ -627,13 +1288,31 @@ void Scene::setPostFilterKernelSize(int n) {
 
 // change post processing filter
 void Scene::useSimpleBlur() {
-    nodes_["post_pass_1"] = nodes_["blur"];
-    nodes_["post_pass_2"] = nullptr;
-    update();
+    setPostEffects({ "blur" });
 }
 void Scene::useTwoPassGauss() {
-    nodes_["post_pass_1"] = nodes_["gauss_1"];
-    nodes_["post_pass_2"] = nodes_["gauss_2"];
+    setPostEffects({ "gauss" });
+}
+void Scene::useDualFilterBlur() {
+    setPostEffects({ "dual_filter" });
+}
+void Scene::useAccumulatedMotionBlur() {
+    setPostEffects({ "motion_accumulate" });
+}
+void Scene::useVelocityMotionBlur() {
+    setPostEffects({ "velocity_blur" });
+}
+void Scene::setMotionBlurFrames(int n)
+{
+    // the ring is re-built with the new size on its next use
+    motionBlurFrames_ = max(n, 1);
+    releasePostHistory_();
+    update();
+}
+void Scene::setPostEffects(const std::vector<QString> &effects)
+{
+    postChain_ = effects;
+    releasePostHistory_();
     update();
 }
 void Scene::toggleJittering(bool value)
@@ -646,12 +1325,63 @@ void Scene::toggleSplitDisplay(bool value)
     split_display_ = value;
     update();
 }
+void Scene::togglePostFusion(bool value)
+{
+    postFusion_ = value;
+    update();
+}
 void Scene::toggleFBODisplay(bool value)
 {
     show_FBOs_ = value;
     update();
 }
 
+// rendering pipeline options
+void Scene::toggleOcclusionQueries(bool value)
+{
+    // one query per object node; post processing rectangles are never occluded
+    for(auto n : nodes_) {
+        auto node = n.second;
+        if(!node || !node->mesh || !dynamic_pointer_cast<PhongMaterial>(node->mesh->material()))
+            continue;
+        // no context is current here, the old query is deleted in draw()
+        if(node->occlusionQuery)
+            retiredQueries_.push_back(node->occlusionQuery);
+        node->occlusionQuery = value? make_shared<OcclusionQuery>(occlusionProxy_) : nullptr;
+    }
+    update();
+}
+void Scene::toggleSinglePassLighting(bool value)
+{
+    singlePassLighting_ = value;
+    update();
+}
+void Scene::toggleDeferredShading(bool value)
+{
+    deferredShading_ = value;
+    update();
+}
+void Scene::toggleClusteredLighting(bool value)
+{
+    clusteredLighting_ = value;
+    update();
+}
+void Scene::toggleDepthPrePass(bool value)
+{
+    depthPrePass_ = value;
+    update();
+}
+void Scene::toggleShadows(bool value)
+{
+    shadows_ = value;
+    update();
+}
+void Scene::toggleStatsOutput(bool value)
+{
+    show_stats_ = value;
+    update();
+}
+
 //player model
 void Scene::togglePlayerVisibility(bool v)
 {
@@ -726,7 +1456,9 @@ void Scene::updateViewport(size_t width, size_t height)
     // make sure the OpenGL viewport projection is correct
     glViewport(0,0,GLint(width),GLint(height));
 
-    // reset (and re-create) FBOs if image size changes
-    new_frame = fbo1_ = fbo2_ = nullptr;
+    // keep rendering at the old size until resizing has settled (see draw()),
+    // and make sure there is a frame once it has
+    lastResize_ = clock_.now();
+    QTimer::singleShot(resizeDelayMs_, this, &Scene::update);
 }
 
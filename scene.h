@@ -12,13 +12,29 @@
 #include "skybox.h"
 #include "material/texphong.h"
 #include "material/postmaterial.h"
+#include "material/velocity.h"
 #include "navigator/position_navigator.h"
 #include "navigator/modeltrackball.h"
 #include "navigator/rotate_y.h"
+#include "render/drawlist.h"
+#include "render/frameuniforms.h"
+#include "render/drawuniforms.h"
+#include "render/materialtable.h"
+#include "render/programcompiler.h"
+#include "render/gbuffer.h"
+#include "render/lightclusters.h"
+#include "render/gputimer.h"
+#include "render/shadowmaps.h"
+#include "render/rendergraph.h"
+#include "render/rendertargetpool.h"
+#include "render/posteffectcomposer.h"
+#include "render/asyncreadback.h"
 
 #include <memory> // std::unique_ptr
 #include <map>    // std::map
 #include <chrono> // clock, time calculations
+#include <vector> // std::vector
+#include <unordered_map> // std::unordered_map
 
 /*
  * OpenGL-based scene. Required objects are created in the constructor,
@@ -74,9 +90,24 @@ public slots:
     void setPostFilterKernelSize(int n);
     void useSimpleBlur();
     void useTwoPassGauss();
+    void useDualFilterBlur();
+    void setPostEffects(const std::vector<QString>& effects);
+    void useAccumulatedMotionBlur();
+    void useVelocityMotionBlur();
+    void setMotionBlurFrames(int n);
     void toggleJittering(bool value);
     void toggleSplitDisplay(bool value);
     void toggleFBODisplay(bool value);
+    void togglePostFusion(bool value);
+
+    // methods affecting the rendering pipeline
+    void toggleOcclusionQueries(bool value);
+    void toggleSinglePassLighting(bool value);
+    void toggleDeferredShading(bool value);
+    void toggleClusteredLighting(bool value);
+    void toggleDepthPrePass(bool value);
+    void toggleShadows(bool value);
+    void toggleStatsOutput(bool value);
 
     // change the node to be rendered in the scene
     void setSceneNode(QString node);
@@ -106,6 +137,9 @@ protected:
     // draw the actual scene
     void draw_scene_();
 
+    // deferred alternative to the light passes of draw_scene_(), lit result in new_frame
+    void draw_deferred_(const Camera& camera);
+
     // parent widget
     QWidget* parent_;
 
@@ -117,6 +151,9 @@ protected:
     std::chrono::time_point<std::chrono::high_resolution_clock> firstDrawTime_;
     std::chrono::time_point<std::chrono::high_resolution_clock> lastDrawTime_;
 
+    // programs created on the GL thread, and time spent compiling / loading them
+    int programsCreated_ = 0;
+    double programMilliseconds_ = 0;
     // game states
     int life = 5;
     //1-4 blocking stance
@@ -135,17 +172,83 @@ protected:
     // bg color
     QVector3D bgcolor_ = QVector3D(0.4f,0.4f,0.4f);
 
-    // draw from FBO for post processing, use full viewport
-    void post_draw_full_(QOpenGLFramebufferObject& fbo, QOpenGLFramebufferObject& fbo2, Node& node);
-    // draw from FBO, render left half of node1 + right half of node2
-    void post_draw_split_(QOpenGLFramebufferObject &fbo1, Node &node1, QOpenGLFramebufferObject &fbo2, QOpenGLFramebufferObject& fbo3, Node &node2);
+    // draw a full-screen rectangle with a post processing node, reading texture (and texture2);
+    // additive: add to the target's contents instead of replacing them
+    void post_draw_(Node& node, GLuint texture, const QSize& size, GLuint texture2 = 0,
+                    bool additive = false);
+
+    // motion of each pixel since the last frame into the bound target, see VelocityMaterial
+    void draw_velocity_();
 
-    // multi-pass rendering
-    std::shared_ptr<QOpenGLFramebufferObject> new_frame, fbo1_, fbo2_;
+    /*
+     *  declare the passes of one post processing effect, reading input.
+     *  The result goes to output if the effect can write there (-1: a new
+     *  image). Returns the image holding the result.
+     */
+    RenderGraph::Handle addPostEffect_(RenderGraph& graph, const QString& effect,
+                                       RenderGraph::Handle input, RenderGraph::Handle output);
+
+    // one pass for a group of effects fused by postComposer_, its program built on first use
+    RenderGraph::Handle addFusedEffects_(RenderGraph& graph, const std::vector<std::string>& group,
+                                         RenderGraph::Handle input, RenderGraph::Handle output);
+
+    // give the motion blur histories back to the pool
+    void releasePostHistory_();
+
+    // multi-pass rendering; the scene image is taken from renderTargets_ each frame
+    std::shared_ptr<QOpenGLFramebufferObject> new_frame;
     std::map<QString, std::shared_ptr<PostMaterial>> post_materials_;
     bool split_display_ = true;
     bool show_FBOs_ = false;
-    bool last_FBO_rendered_was_one = true;
+
+    // post processing effects applied in order, see addPostEffect_()
+    std::vector<QString> postChain_ = { "motion_blur" };
+
+    // simple effects in a row run as one generated pass; programs by group, see addFusedEffects_()
+    PostEffectComposer postComposer_;
+    bool postFusion_ = true;
+    std::map<std::string, std::shared_ptr<ProgramCompiler::Request>> fusedPrograms_;
+    std::shared_ptr<QOpenGLShaderProgram> postFallbackProgram_;
+    // scene image and intermediate images of the post processing graph
+    RenderTargetPool renderTargets_;
+    // motion blur: last frame's result, and the one being written (half float, from the pool)
+    std::shared_ptr<QOpenGLFramebufferObject> postHistory_[2];
+    size_t postHistoryIndex_ = 0;
+
+    /*
+     *  accumulated motion blur: the last motionBlurFrames_ frames in a ring,
+     *  and their running sum (float), updated by adding the newest frame and
+     *  subtracting the oldest one. accumulated_ counts the frames in the sum.
+     */
+    int motionBlurFrames_ = 8;
+    std::vector<std::shared_ptr<QOpenGLFramebufferObject>> accumulationRing_;
+    std::shared_ptr<QOpenGLFramebufferObject> accumulationSum_;
+    size_t accumulationIndex_ = 0;
+    int accumulated_ = 0;
+
+    /*
+     *  velocity motion blur: per-pixel motion (from the pool, each frame), and
+     *  what is needed to compute it: last frame's view-projection and model
+     *  matrices. Nodes drawn more than once share one entry.
+     */
+    std::shared_ptr<QOpenGLFramebufferObject> velocity_;
+    std::shared_ptr<VelocityMaterial> velocityMaterial_;
+    QMatrix4x4 viewProjection_, previousViewProjection_;
+    std::unordered_map<const Node*, QMatrix4x4> previousModel_;
+    // copy of the post processing result, for the FBO display
+    std::shared_ptr<QOpenGLFramebufferObject> postInspected_;
+    // FBO display: buffer contents are read back asynchronously
+    std::unique_ptr<AsyncReadback> readback_;
+
+    /*
+     *  size of the images rendered into. While the window is being resized,
+     *  the old size is kept and the result scaled to the window; the
+     *  targets are only re-allocated once the size has not changed for
+     *  resizeDelayMs_.
+     */
+    QSize renderSize_;
+    std::chrono::time_point<std::chrono::high_resolution_clock> lastResize_;
+    int resizeDelayMs_ = 250;
 
     // different materials to be demonstrated
     std::map<QString, std::shared_ptr<TexturedPhongMaterial>> materials_;
@@ -156,22 +259,96 @@ protected:
     // nodes to be used
     std::map<QString, std::shared_ptr<Node>> nodes_;
 
+    // bounding box mesh for occlusion queries
+    std::shared_ptr<Mesh> occlusionProxy_;
+
+    // queries switched off by the UI, deleted in draw() where the context is current
+    std::vector<std::shared_ptr<OcclusionQuery>> retiredQueries_;
+
+    // print render statistics every few frames?
+    bool show_stats_ = false;
+
+    // shade all lights in one pass, or add one pass per light?
+    bool singlePassLighting_ = true;
+
+    // deferred pipeline: G-buffer, then one screen-space pass per light
+    bool deferredShading_ = false;
+    std::unique_ptr<GBuffer> gbuffer_;
+    std::shared_ptr<Mesh> deferredLight_;
+
+    // forward pipeline: depth-only pass first, then light passes with GL_EQUAL
+    bool depthPrePass_ = false;
+    std::shared_ptr<Material> depthPrePassMaterial_;
+
+    // GPU time of the forward passes, [0]: without, [1]: with depth pre-pass
+    std::unique_ptr<GpuTimer> forwardTimers_[2];
+
+    // cached shadow maps of the lights (forward pipeline), and all shadow casters
+    bool shadows_ = false;
+    std::unique_ptr<ShadowMaps> shadowMaps_;
+    DrawListBuilder casterListBuilder_;
+    DrawList casterList_;
+
+    // forward shading with lights binned into clusters, includes the torches below
+    bool clusteredLighting_ = false;
+    std::unique_ptr<LightClusters> lightClusters_;
+
+    // many small animated lights, only visible with clustered lighting
+    struct Torch {
+        QVector3D center;     // circle center in world coordinates
+        float radius, speed;  // circle radius, angular speed (rad/s)
+        float phase;          // initial angle
+        float range;          // see LightClusters::Light
+        QVector3D intensity;
+    };
+    std::vector<Torch> torches_;
+
     // skybox
     std::shared_ptr<SkyBox> skybox_;
     bool drawSkyBox_ = false;
 
+    // CPU frame preparation: draw list of the scene, rebuilt every frame
+    DrawListBuilder drawListBuilder_;
+    DrawList drawList_;
+
     // light nodes for any number of lights
     std::vector<std::shared_ptr<Node>> lightNodes_;
 
+    // per-frame uniforms (camera, lights, time), shared by all programs
+    std::unique_ptr<FrameUniforms> frameUniforms_;
+
+    // per-draw matrices of drawList_, streamed once per frame
+    std::unique_ptr<DrawUniforms> drawUniforms_;
+
+    // parameters of all Phong materials, uploaded when they change
+    std::unique_ptr<MaterialTable> materialTable_;
+
     // navigation
     std::unique_ptr<ModelTrackball> navigator_;
     std::unique_ptr<PositionNavigator> lightNavigator_;
     std::unique_ptr<RotateY> cameraNavigator_;
 
-    // helper for creating programs from shader files
+    // background compilation, polled every frame. programsPending_ is only
+    // used to report once when the startup programs are all ready.
+    // declared last, so the worker stops before anything else is destroyed.
+    std::unique_ptr<ProgramCompiler> programCompiler_;
+    bool programsPending_ = true;
+
+    // helper for creating programs from shader files, optionally with #define lines
     std::shared_ptr<QOpenGLShaderProgram> createProgram(const std::string& vertex,
                                                         const std::string& fragment,
-                                                        const std::string& geom = "");
+                                                        const std::string& geom = "",
+                                                        const std::string& defines = "");
+
+    // same, without blocking: ready is called from draw() when the program is linked
+    std::shared_ptr<ProgramCompiler::Request> createProgramAsync(const std::string& vertex,
+                                                                 const std::string& fragment,
+                                                                 ProgramCompiler::Ready ready,
+                                                                 const std::string& defines = "");
+
+    // same, with generated fragment shader source instead of a file; poll the request for the program
+    std::shared_ptr<ProgramCompiler::Request> createGeneratedProgramAsync(const std::string& vertex,
+                                                                          const std::string& fragmentSource);
 
     // helper for creating a node scaled to size 1
     std::shared_ptr<Node> createNode(std::shared_ptr<Mesh> mesh, bool scale_to_1 = true);
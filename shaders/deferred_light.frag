@@ -0,0 +1,91 @@
+/*
+ * fragment shader for deferred light passes: Phong illumination
+ * from the G-buffer (see GBuffer), one light per pass
+ *
+ */
+
+#version 150
+
+in vec2 texcoord_frag;
+
+// output: color, added up over the light passes
+out vec4 outColor;
+
+// G-buffer targets
+uniform sampler2D gAlbedo;      // diffuse color, shininess / 255
+uniform sampler2D gNormalDepth; // normal (WC), linear view depth
+uniform sampler2D gEmission;    // ambient + emissive + environment, specular intensity
+
+// index of the light for this pass; pass 0 also adds the emission
+uniform int lightPass;
+
+// per-frame data, shared by all programs (see FrameUniforms)
+struct FrameLight {
+    vec4 position_WC;
+    vec4 intensity;   // w: range, <= 0: unbounded
+};
+layout(std140) uniform FrameData {
+    mat4  viewMatrix;
+    mat4  inverseViewMatrix;
+    mat4  projectionMatrix;
+    mat4  viewProjectionMatrix;
+    vec3  ambientLightIntensity;
+    float time;
+    int   numLights;
+    FrameLight lights[8];
+};
+
+// smooth falloff to zero at the light's range; range <= 0: unbounded
+float attenuation(vec3 toLight, float range) {
+    if(range <= 0.0)
+        return 1.0;
+    float x = clamp(1.0 - dot(toLight, toLight) / (range * range), 0.0, 1.0);
+    return x * x;
+}
+
+void main() {
+
+    vec4 albedo      = texture(gAlbedo, texcoord_frag);
+    vec4 normalDepth = texture(gNormalDepth, texcoord_frag);
+    vec4 emission    = texture(gEmission, texcoord_frag);
+
+    // position in eye coordinates from the linear depth (symmetric perspective projection)
+    float depth = normalDepth.w;
+    vec2 ndc = texcoord_frag * 2.0 - 1.0;
+    vec3 position_EC = vec3(ndc.x / projectionMatrix[0][0] * depth,
+                            ndc.y / projectionMatrix[1][1] * depth,
+                            -depth);
+    vec3 position_WC = (inverseViewMatrix * vec4(position_EC, 1.0)).xyz;
+
+    // ambient / emissive part, only added in first light pass
+    vec3 color = vec3(0,0,0);
+    if(lightPass == 0)
+        color = emission.rgb;
+
+    if(lightPass < numLights) {
+
+        vec3 n = normalize(normalDepth.xyz);
+        vec3 toLight = lights[lightPass].position_WC.xyz - position_WC;
+        vec3 l = normalize(toLight);
+        vec3 intensity = lights[lightPass].intensity.rgb *
+                         attenuation(toLight, lights[lightPass].intensity.w);
+        vec3 v = normalize(inverseViewMatrix[3].xyz - position_WC);
+
+        // cosine of angle between light and surface normal.
+        float ndotl = dot(n,l);
+        if(ndotl > 0.0) {
+
+            // diffuse term
+            vec3 diffuse = albedo.rgb * intensity * ndotl;
+
+            // specular term, intensity and exponent from the G-buffer
+            float rdotv = max(dot(reflect(-l,n), v), 0.0);
+            vec3 specular = emission.a * intensity * pow(rdotv, albedo.a * 255.0);
+
+            color += diffuse + specular;
+        }
+    }
+
+    outColor = vec4(color, 1.0);
+
+}
@@ -0,0 +1,19 @@
+/*
+ * vertex shader for deferred light passes
+ *
+ */
+
+#version 150
+
+// full-viewport rectangle, -1...1 in x and y
+in vec3 position_MC;
+
+// position in the G-buffer
+out vec2 texcoord_frag;
+
+void main(void) {
+    // on the far plane: with depth test GL_GREATER, only pixels covered
+    // by geometry are lit (the G-buffer's depth is in the target frame)
+    gl_Position = vec4(position_MC.xy, 1.0, 1.0);
+    texcoord_frag = position_MC.xy * 0.5 + 0.5;
+}
@@ -0,0 +1,11 @@
+/*
+ * fragment shader for depth-only passes and proxy geometry:
+ * nothing to do, only the depth value is of interest
+ *
+ */
+
+#version 150
+
+void main() {
+}
+
@@ -0,0 +1,17 @@
+/*
+ * vertex shader for depth-only passes and proxy geometry
+ *
+ */
+
+#version 150
+
+// transformation matrices
+uniform mat4 modelViewProjectionMatrix;
+
+// in: position in model coordinates (_MC)
+in vec3 position_MC;
+
+void main(void) {
+    gl_Position = modelViewProjectionMatrix * vec4(position_MC,1);
+}
+
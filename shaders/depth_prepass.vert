@@ -0,0 +1,26 @@
+/*
+ * vertex shader for the depth pre-pass: positions exactly as
+ * phong.vert / textured_phong.vert compute them, so the light
+ * passes can test with GL_EQUAL
+ *
+ */
+
+#version 150
+
+// per-draw data, a slice of the draw list's buffer (see DrawUniforms)
+layout(std140) uniform DrawData {
+    mat4 modelMatrix;
+    mat4 modelViewMatrix;
+    mat4 modelViewProjectionMatrix;
+    mat3 normalMatrix;
+};
+
+// in: position in model coordinates (_MC)
+in vec3 position_MC;
+
+// same expression in all programs of the pre-pass and the light passes
+invariant gl_Position;
+
+void main(void) {
+    gl_Position = modelViewProjectionMatrix * vec4(position_MC,1);
+}
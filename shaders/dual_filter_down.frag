@@ -0,0 +1,36 @@
+/*
+ * Dual Filter Blur, downsampling step (see DualFilterMaterial)
+ *
+ */
+
+#version 150
+
+// texture to be blurred (twice the output size), sampled with linear filtering
+uniform sampler2D post_tex;
+
+// size of the texture in pixels
+uniform int image_width;
+uniform int image_height;
+
+// distance of the taps in texels
+uniform float offset;
+
+// texture coords
+in vec2 texcoord_frag;
+
+// output: color
+out vec4 outColor;
+
+void main(void)
+{
+    vec2 d = offset / vec2(image_width, image_height);
+
+    // center, and four corners each averaging 2x2 texels
+    vec3 color = texture(post_tex, texcoord_frag).rgb * 4.0;
+    color += texture(post_tex, texcoord_frag - d).rgb;
+    color += texture(post_tex, texcoord_frag + d).rgb;
+    color += texture(post_tex, texcoord_frag + vec2(d.x, -d.y)).rgb;
+    color += texture(post_tex, texcoord_frag - vec2(d.x, -d.y)).rgb;
+
+    outColor = vec4(color / 8.0, 1);
+}
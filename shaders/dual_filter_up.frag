@@ -0,0 +1,39 @@
+/*
+ * Dual Filter Blur, upsampling step (see DualFilterMaterial)
+ *
+ */
+
+#version 150
+
+// texture to be blurred (half the output size), sampled with linear filtering
+uniform sampler2D post_tex;
+
+// size of the texture in pixels
+uniform int image_width;
+uniform int image_height;
+
+// distance of the taps in texels
+uniform float offset;
+
+// texture coords
+in vec2 texcoord_frag;
+
+// output: color
+out vec4 outColor;
+
+void main(void)
+{
+    vec2 d = offset / vec2(image_width, image_height);
+
+    // four taps on the axes, four (weighted twice) on the diagonals
+    vec3 color = texture(post_tex, texcoord_frag + vec2(-d.x, 0)).rgb;
+    color += texture(post_tex, texcoord_frag + vec2( d.x, 0)).rgb;
+    color += texture(post_tex, texcoord_frag + vec2(0, -d.y)).rgb;
+    color += texture(post_tex, texcoord_frag + vec2(0,  d.y)).rgb;
+    color += texture(post_tex, texcoord_frag + 0.5 * vec2(-d.x,  d.y)).rgb * 2.0;
+    color += texture(post_tex, texcoord_frag + 0.5 * vec2( d.x,  d.y)).rgb * 2.0;
+    color += texture(post_tex, texcoord_frag + 0.5 * vec2( d.x, -d.y)).rgb * 2.0;
+    color += texture(post_tex, texcoord_frag + 0.5 * vec2(-d.x, -d.y)).rgb * 2.0;
+
+    outColor = vec4(color / 12.0, 1);
+}
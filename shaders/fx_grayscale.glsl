@@ -0,0 +1,8 @@
+/*
+ * Post effect snippet (pointwise, see PostEffectComposer):
+ * luminance only
+ */
+vec3 grayscale(vec3 color, vec2 uv)
+{
+    return vec3(dot(color, vec3(0.2126, 0.7152, 0.0722)));
+}
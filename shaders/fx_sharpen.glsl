@@ -0,0 +1,11 @@
+/*
+ * Post effect snippet (neighborhood, see PostEffectComposer):
+ * unsharp mask with the four direct neighbours
+ */
+vec3 sharpen(vec2 uv)
+{
+    vec3 center = SOURCE(uv);
+    vec3 blurred = (SOURCE(uv + vec2(TEXEL.x, 0)) + SOURCE(uv - vec2(TEXEL.x, 0)) +
+                    SOURCE(uv + vec2(0, TEXEL.y)) + SOURCE(uv - vec2(0, TEXEL.y))) * 0.25;
+    return center + (center - blurred) * 0.8;
+}
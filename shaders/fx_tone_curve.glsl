@@ -0,0 +1,10 @@
+/*
+ * Post effect snippet (pointwise, see PostEffectComposer):
+ * gentle S-curve for contrast, with slightly lifted blacks
+ */
+vec3 tone_curve(vec3 color, vec2 uv)
+{
+    vec3 c = clamp(color, 0.0, 1.0);
+    c = c * c * (3.0 - 2.0 * c);
+    return mix(vec3(0.02), vec3(1.0), mix(color, c, 0.6));
+}
@@ -0,0 +1,9 @@
+/*
+ * Post effect snippet (pointwise, see PostEffectComposer):
+ * darkens the image towards the corners
+ */
+vec3 vignette(vec3 color, vec2 uv)
+{
+    float d = length(uv - vec2(0.5)) * 1.41421356;
+    return color * (1.0 - 0.6 * smoothstep(0.5, 1.0, d));
+}
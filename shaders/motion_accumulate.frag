@@ -0,0 +1,35 @@
+/*
+ * Accumulated Motion Blur, running sum update:
+ * adds the newest frame and subtracts the oldest one of the ring.
+ * Drawn with additive blending into the (float) sum.
+ *
+ * The ring stores 8 bit frames, so the newest frame is quantized the
+ * same way here and the sum counts steps of 1/255. Integer counts stay
+ * exact in a float, the sum never drifts from what the ring holds.
+ *
+ */
+
+#version 150
+
+// newest frame
+uniform sampler2D post_tex;
+// oldest frame, leaving the window
+uniform sampler2D post_tex2;
+
+// texture coords
+in vec2 texcoord_frag;
+
+// output: change of the sum
+out vec4 outColor;
+
+// 8 bit unorm value of a color, as stored in the ring
+vec3 steps(vec3 c)
+{
+    return floor(clamp(c, 0.0, 1.0) * 255.0 + 0.5);
+}
+
+void main(void)
+{
+    outColor = vec4(steps(texture(post_tex, texcoord_frag).rgb) -
+                    steps(texture(post_tex2, texcoord_frag).rgb), 0);
+}
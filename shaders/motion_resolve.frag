@@ -0,0 +1,23 @@
+/*
+ * Accumulated Motion Blur, resolve: average of the frames in the sum
+ *
+ */
+
+#version 150
+
+// sum of the last frames, in steps of 1/255 (see motion_accumulate.frag)
+uniform sampler2D post_tex;
+
+// number of frames in the sum
+uniform int frames;
+
+// texture coords
+in vec2 texcoord_frag;
+
+// output: color
+out vec4 outColor;
+
+void main(void)
+{
+    outColor = vec4(texture(post_tex, texcoord_frag).rgb / (255.0 * float(frames)), 1);
+}
@@ -19,66 +19,119 @@ struct PhongMaterial {
     float shininess;
 
 };
-uniform PhongMaterial phong;
-uniform vec3 ambientLightIntensity;
 
-struct PointLight {
-    vec3 intensity;
+// parameters of all materials (see MaterialTable)
+struct MaterialRecord {
+    vec4  k_ambient;
+    vec4  k_diffuse;
+    vec4  k_specular;    // w: shininess
+    vec4  k_mirror;      // w: refract_ratio
+    vec4  k_refract;     // w: emissive_scale
+    ivec4 textures;      // use diffuse, emissive, gloss, environment
+    ivec4 mapping;       // bump use, bump debug, displacement use
+    vec4  scales;        // bump scale, displacement scale
+};
+layout(std140) uniform MaterialData {
+    MaterialRecord materials[64];
+};
+uniform int materialIndex;
+
+// parameters of the current material, see loadMaterial()
+PhongMaterial phong;
+
+// unpack the record of the current material
+void loadMaterial() {
+    MaterialRecord m = materials[materialIndex];
+    phong = PhongMaterial(m.k_ambient.rgb, m.k_diffuse.rgb, m.k_specular.rgb, m.k_specular.w);
+}
+
+// index of the light for this pass, -1: all lights in a single pass
+uniform int lightPass;
+
+// per-frame data, shared by all programs (see FrameUniforms)
+struct FrameLight {
     vec4 position_WC;
-    int  pass;
+    vec4 intensity;   // w: range, <= 0: unbounded
+};
+layout(std140) uniform FrameData {
+    mat4  viewMatrix;
+    mat4  inverseViewMatrix;
+    mat4  projectionMatrix;
+    mat4  viewProjectionMatrix;
+    vec3  ambientLightIntensity;
+    float time;
+    int   numLights;
+    FrameLight lights[8];
 };
-uniform PointLight light;
 
-uniform mat4 viewMatrix;
+// smooth falloff to zero at the light's range; range <= 0: unbounded
+float attenuation(vec3 toLight, float range) {
+    if(range <= 0.0)
+        return 1.0;
+    float x = clamp(1.0 - dot(toLight, toLight) / (range * range), 0.0, 1.0);
+    return x * x;
+}
 
 /*
- *  Calculate surface color based on Phong illumination model.
+ *  Calculate surface color based on Phong illumination model,
+ *  for the light of this pass or for all lights.
  */
 
-vec3 myphong(vec3 n, vec3 v, vec3 l) {
-
-    // cosine of angle between light and surface normal.
-    float ndotl = dot(n,l);
+vec3 myphong(vec3 n, vec3 v) {
 
     // ambient / emissive part
-    vec3 ambient = vec3(0,0,0);
-    if(light.pass == 0) // only add ambient in first light pass
-        ambient = phong.k_ambient * ambientLightIntensity;
+    vec3 color = vec3(0,0,0);
+    if(lightPass <= 0) // only add ambient in first light pass
+        color = phong.k_ambient * ambientLightIntensity;
+
+    // lights of this pass: one, or all of them
+    int first = max(lightPass, 0);
+    int last  = lightPass < 0? numLights : lightPass + 1;
+    for(int i=first; i<last; i++) {
+
+        // direction to the light in camera/eye coordinates
+        vec4 lightpos_EC = viewMatrix * lights[i].position_WC;
+        vec3 toLight = (lightpos_EC - position_EC).xyz;
+        vec3 l = normalize(toLight);
+        vec3 intensity = lights[i].intensity.rgb * attenuation(toLight, lights[i].intensity.w);
 
-    // surface back-facing to light?
-    if(ndotl<=0.0)
-        return ambient;
-    else
-        ndotl = max(ndotl, 0.0);
+        // cosine of angle between light and surface normal.
+        float ndotl = dot(n,l);
 
-    // diffuse term
-    vec3 diffuse =  phong.k_diffuse * light.intensity * ndotl;
+        // surface back-facing to light?
+        if(ndotl<=0.0)
+            continue;
 
-    // reflected light direction = perfect reflection direction
-    vec3 r = reflect(-l,n);
+        // diffuse term
+        vec3 diffuse =  phong.k_diffuse * intensity * ndotl;
 
-    // cosine of angle between reflection dir and viewing dir
-    float rdotv = max( dot(r,v), 0.0);
+        // reflected light direction = perfect reflection direction
+        vec3 r = reflect(-l,n);
 
-    // specular contribution + gloss map
-    vec3 specular = phong.k_specular * light.intensity * pow(rdotv, phong.shininess);
+        // cosine of angle between reflection dir and viewing dir
+        float rdotv = max( dot(r,v), 0.0);
+
+        // specular contribution + gloss map
+        vec3 specular = phong.k_specular * intensity * pow(rdotv, phong.shininess);
+
+        color += diffuse + specular;
+    }
 
     // return sum of all contributions
-    return ambient + diffuse + specular;
+    return color;
 
 }
 
 void main() {
 
+    loadMaterial();
+
     // calculate all required vectors in camera/eye coordinates
-    vec4 lightpos_EC = viewMatrix * light.position_WC;
-    vec3 lightdir_EC = (lightpos_EC   - position_EC).xyz;
     vec3 viewdir_EC  = (vec4(0,0,0,1) - position_EC).xyz;
 
     // calculate color using phong, all vectors in eye coordinates
     vec3 final_color = myphong(normalize(normal_EC),
-                               normalize(viewdir_EC),
-                               normalize(lightdir_EC));
+                               normalize(viewdir_EC));
 
     // set output
     outColor = vec4(final_color, 1.0);
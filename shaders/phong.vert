@@ -6,14 +6,13 @@
 
 #version 150
 
-// transformation matrices
-uniform mat4 modelViewProjectionMatrix;
-uniform mat4 projectionMatrix;
-uniform mat4 modelViewMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 inverseViewMatrix;
-uniform mat4 modelMatrix;
-uniform mat3 normalMatrix;
+// per-draw data, a slice of the draw list's buffer (see DrawUniforms)
+layout(std140) uniform DrawData {
+    mat4 modelMatrix;
+    mat4 modelViewMatrix;
+    mat4 modelViewProjectionMatrix;
+    mat3 normalMatrix;
+};
 
 // in: position and normal vector in model coordinates (_MC)
 in vec3 position_MC;
@@ -22,13 +21,16 @@ in vec3 normal_MC;
 out vec4 position_EC;
 out vec3 normal_EC;
 
+// bit-identical to the depth pre-pass (depth_prepass.vert), for GL_EQUAL
+invariant gl_Position;
+
 void main(void) {
 
     // vertex/fragment position in eye coordinates
     position_EC = modelViewMatrix * vec4(position_MC,1);
 
     // position in clip coordinates
-    gl_Position  = projectionMatrix * position_EC;
+    gl_Position  = modelViewProjectionMatrix * vec4(position_MC,1);
 
     // normal direction in eye coordinates
     normal_EC  = normalMatrix * normal_MC;
@@ -0,0 +1,52 @@
+/*
+ * Separable Blur Shader, one direction (see SeparableBlurMaterial)
+ *
+ */
+
+#version 150
+
+// texture to be blurred, sampled with linear filtering
+uniform sampler2D post_tex;
+
+// size of the texture in pixels
+uniform int image_width;
+uniform int image_height;
+
+// blur along y instead of x?
+uniform bool vertical;
+
+// use jittering?
+uniform bool use_jitter;
+
+// one-sided taps, center first; offsets in pixels, between two texels
+const int MAX_TAPS = 16;
+uniform int taps;
+uniform float weights[MAX_TAPS];
+uniform float offsets[MAX_TAPS];
+
+// texture coords
+in vec2 texcoord_frag;
+
+// output: color
+out vec4 outColor;
+
+// simple pseudo random number
+float rand(vec2 xy){
+    return fract(sin(dot(xy, vec2(12.9898,78.233))) * 43758.5453);
+}
+
+void main(void)
+{
+    vec2 step = vertical? vec2(0, 1.0/float(image_height)) : vec2(1.0/float(image_width), 0);
+
+    // one random shift per pixel, up to half a texel
+    float jitter = use_jitter? rand(texcoord_frag) - 0.5 : 0.0;
+    vec2 tc = texcoord_frag + jitter * step;
+
+    vec3 color = texture(post_tex, tc).rgb * weights[0];
+    for(int i = 1; i < taps; i++) {
+        color += texture(post_tex, tc + offsets[i] * step).rgb * weights[i];
+        color += texture(post_tex, tc - offsets[i] * step).rgb * weights[i];
+    }
+    outColor = vec4(color, 1);
+}
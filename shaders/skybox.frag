@@ -22,9 +22,21 @@ uniform SkyBox skybox;
 
 uniform samplerCube cubeMap;
 
-// matrices
-uniform mat4 viewMatrix;
-uniform mat4 projectionMatrix;
+// per-frame data, shared by all programs (see FrameUniforms)
+struct FrameLight {
+    vec4 position_WC;
+    vec4 intensity;   // w: range, <= 0: unbounded
+};
+layout(std140) uniform FrameData {
+    mat4  viewMatrix;
+    mat4  inverseViewMatrix;
+    mat4  projectionMatrix;
+    mat4  viewProjectionMatrix;
+    vec3  ambientLightIntensity;
+    float time;
+    int   numLights;
+    FrameLight lights[8];
+};
 
 
 void main() {
@@ -37,7 +49,7 @@ void main() {
 
     // vector from eye to vertex
     vec3 toVertexEC = usePerspective? normalize(position_EC.xyz) : vec3(0,0,-1);
-    vec3 toVertexWC = (inverse(viewMatrix) * vec4(toVertexEC,0)).xyz;
+    vec3 toVertexWC = (inverseViewMatrix * vec4(toVertexEC,0)).xyz;
 
     // simply look up color in environment map, along viewing ray
     vec3 sky = texture(cubeMap, toVertexWC).rgb * skybox.intensity_scale;
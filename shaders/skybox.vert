@@ -7,7 +7,7 @@
 #version 150
 
 // transformation matrices
-uniform mat4 projectionMatrix;
+uniform mat4 modelViewProjectionMatrix;
 uniform mat4 modelViewMatrix;
 uniform mat3 normalMatrix;
 
@@ -36,7 +36,7 @@ void main(void) {
     normal_EC     = normalMatrix*normal_MC;
 
     // set the fragment position in clip coordinates
-    gl_Position  = projectionMatrix * position_EC;
+    gl_Position  = modelViewProjectionMatrix * vec4(position_MC,1.0);
 
 }
 
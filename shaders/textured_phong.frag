@@ -3,7 +3,7 @@
  *
  */
 
-#version 150
+#version 330
 
 // output - transformed to eye coordinates (EC)
 in vec4 position_EC;
@@ -11,19 +11,23 @@ in vec3 normal_EC;
 
 // output - transformed to tangent space (TS)
 in vec3 viewDir_TS;
-in vec3 lightDir_TS;
+
+// world coordinates (WC), for the light directions
+in vec3 position_WC;
+in mat3 TBN_WC;
 
 // tex coords - just copied
 in vec2 texcoord_frag;
 
+#ifdef GBUFFER_OUTPUT
+// deferred shading: surface attributes for the light passes (see GBuffer)
+layout(location = 0) out vec4 gAlbedo;      // diffuse color, shininess / 255
+layout(location = 1) out vec4 gNormalDepth; // normal (WC), linear view depth
+layout(location = 2) out vec4 gEmission;    // ambient + emissive + environment, specular intensity
+#else
 // output: color
 out vec4 outColor;
-
-struct PointLight {
-    vec3 intensity;
-    vec4 position_WC;
-    int  pass;
-};
+#endif
 
 struct PhongMaterial {
     vec3 k_ambient;
@@ -41,74 +45,172 @@ struct EnvMap {
 };
 
 struct TexturedMaterial {
-    bool useDiffuseTexture;
-    bool useEmissiveTexture;
-    bool useGlossTexture;
-    bool useEnvironmentTexture;
     float emissive_scale;
 };
 
 struct BumpMaterial {
-    bool use;
     bool debug;
     float scale;
 };
 
-struct DisplacementMaterial {
-    bool use;
-    float scale;
+// index of the light for this pass, -1: all lights in a single pass
+uniform int lightPass;
+
+// parameters of all materials (see MaterialTable)
+struct MaterialRecord {
+    vec4  k_ambient;
+    vec4  k_diffuse;
+    vec4  k_specular;    // w: shininess
+    vec4  k_mirror;      // w: refract_ratio
+    vec4  k_refract;     // w: emissive_scale
+    ivec4 textures;      // use diffuse, emissive, gloss, environment
+    ivec4 mapping;       // bump use, bump debug, displacement use
+    vec4  scales;        // bump scale, displacement scale
+};
+layout(std140) uniform MaterialData {
+    MaterialRecord materials[64];
 };
+uniform int materialIndex;
+
+// parameters of the current material, see loadMaterial()
+PhongMaterial phong;
+TexturedMaterial tex;
+BumpMaterial bump;
+EnvMap envmap;
 
-uniform PointLight light;
-uniform PhongMaterial phong;
-uniform TexturedMaterial tex;
-uniform BumpMaterial bump;
-uniform DisplacementMaterial displacement;
-uniform EnvMap envmap;
+/*
+ *  Which textures are used is not decided at runtime: each combination
+ *  is compiled into its own program variant, see TexturedPhongMaterial.
+ *  Features: DIFFUSE_TEXTURE, EMISSIVE_TEXTURE, GLOSS_TEXTURE,
+ *  ENVIRONMENT_TEXTURE, BUMP_MAPPING (DISPLACEMENT_MAPPING: vertex shader),
+ *  GBUFFER_OUTPUT, CLUSTERED_LIGHTS, SHADOWS
+ */
+#ifdef DIFFUSE_TEXTURE
 uniform sampler2D diffuseTexture;
+#endif
+#ifdef EMISSIVE_TEXTURE
 uniform sampler2D emissiveTexture;
+#endif
+#ifdef GLOSS_TEXTURE
 uniform sampler2D glossTexture;
+#endif
+#ifdef BUMP_MAPPING
 uniform sampler2D bumpTexture;
+#endif
+#ifdef ENVIRONMENT_TEXTURE
 uniform samplerCube environmentTexture;
+#endif
+#ifdef SHADOWS
+// cached cube shadow maps of up to two lights, see ShadowMaps
+uniform sampler2DArrayShadow shadowAtlas;   // layers: static casters, dynamic casters
+uniform mat4 shadowMatrices[12];            // per shadowed light: 6 cube faces, WC -> atlas
+uniform int  shadowLights[2];               // FrameData index of each shadowed light, -1: none
+#endif
+#ifdef CLUSTERED_LIGHTS
+// lights binned into view space clusters, see LightClusters
+uniform samplerBuffer  clusterLights;       // 2 texels per light: position_WC + range, intensity
+uniform usamplerBuffer clusterGrid;         // per cluster: first index, number of lights
+uniform usamplerBuffer clusterLightIndices; // light indices of all clusters
+uniform vec4 clusterParams;                 // tile size in pixels, near depth, slices / log(far / near)
+uniform vec3 clusterCount;                  // tiles x, tiles y, slices
+#endif
+
+// per-frame data, shared by all programs (see FrameUniforms)
+struct FrameLight {
+    vec4 position_WC;
+    vec4 intensity;   // w: range, <= 0: unbounded
+};
+layout(std140) uniform FrameData {
+    mat4  viewMatrix;
+    mat4  inverseViewMatrix;
+    mat4  projectionMatrix;
+    mat4  viewProjectionMatrix;
+    vec3  ambientLightIntensity;
+    float time;
+    int   numLights;
+    FrameLight lights[8];
+};
 
-// standard uniforms
-uniform mat4  viewMatrix;
-uniform mat4  inverseViewMatrix;
-uniform mat4  projectionMatrix;
-uniform float time;
-uniform vec3  ambientLightIntensity;
+// unpack the record of the current material
+void loadMaterial() {
+    MaterialRecord m = materials[materialIndex];
+    phong  = PhongMaterial(m.k_ambient.rgb, m.k_diffuse.rgb, m.k_specular.rgb, m.k_specular.w, false);
+    tex    = TexturedMaterial(m.k_refract.w);
+    bump   = BumpMaterial(m.mapping.y != 0, m.scales.x);
+    envmap = EnvMap(m.k_mirror.rgb, m.k_refract.rgb, m.k_mirror.w);
+}
 
-/*
- *  Calculate surface color based on Phong illumination model.
- */
+// diffuse color, from the texture or the material
+vec3 surfaceDiffuse(vec2 uv) {
+#ifdef DIFFUSE_TEXTURE
+    return texture(diffuseTexture, uv).rgb;
+#else
+    return phong.k_diffuse;
+#endif
+}
+
+// Phong exponent, from the gloss map or the material
+float surfaceShininess(vec2 uv) {
+#ifdef GLOSS_TEXTURE
+    return texture(glossTexture, uv).r * 255.0; // 0...255
+#else
+    return phong.shininess;
+#endif
+}
+
+// ambient / emissive part
+vec3 surfaceAmbient(vec2 uv) {
+#ifdef EMISSIVE_TEXTURE
+    return texture(emissiveTexture, uv).rgb * tex.emissive_scale;
+#else
+    return phong.k_ambient * ambientLightIntensity;
+#endif
+}
+
+// smooth falloff to zero at the light's range; range <= 0: unbounded
+float attenuation(vec3 toLight, float range) {
+    if(range <= 0.0)
+        return 1.0;
+    float x = clamp(1.0 - dot(toLight, toLight) / (range * range), 0.0, 1.0);
+    return x * x;
+}
 
-vec3 texphong(vec3 n, vec3 v, vec3 l, vec2 uv) {
+#ifdef SHADOWS
+// fraction of light i (FrameData index) reaching the fragment, 1 without shadow map
+float shadow(int i) {
+    for(int k=0; k<2; k++) {
+        if(shadowLights[k] != i)
+            continue;
+
+        // cube face: major axis of the direction from the light (+X, -X, +Y, -Y, +Z, -Z)
+        vec3 d = position_WC - lights[i].position_WC.xyz;
+        vec3 a = abs(d);
+        int face = a.x >= a.y && a.x >= a.z? (d.x >= 0.0? 0 : 1) :
+                   a.y >= a.z?               (d.y >= 0.0? 2 : 3) :
+                                             (d.z >= 0.0? 4 : 5);
+        vec4 p = shadowMatrices[6*k + face] * vec4(position_WC, 1.0);
+        p.xyz /= p.w;
+
+        // occluded by a static or by a dynamic caster
+        return min(texture(shadowAtlas, vec4(p.xy, 0.0, p.z)),
+                   texture(shadowAtlas, vec4(p.xy, 1.0, p.z)));
+    }
+    return 1.0;
+}
+#endif
 
-    // texture lookups
-    vec3  diffCol  = texture(diffuseTexture, uv).rgb;
-    vec3  emissCol = texture(emissiveTexture, uv).rgb * tex.emissive_scale;
-    float gloss    = texture(glossTexture, uv).r * 255.0; // 0...255
+// diffuse + specular contribution of one light, direction l and intensity in tangent space
+vec3 shadeLight(vec3 n, vec3 v, vec3 l, vec3 intensity, vec3 diffuseCoeff, float shininess) {
 
     // cosine of angle between light and surface normal.
     float ndotl = dot(n,l);
 
-    // ambient / emissive part
-    vec3 ambient = vec3(0,0,0);
-    if(light.pass == 0) // only add ambient in first light pass
-        ambient = tex.useEmissiveTexture?
-                  emissCol : phong.k_ambient * ambientLightIntensity;
-
     // surface back-facing to light?
     if(ndotl<=0.0)
-        return ambient;
-    else
-        ndotl = max(ndotl, 0.0);
-
-    // diffuse contribution
-    vec3 diffuseCoeff = tex.useDiffuseTexture? diffCol : phong.k_diffuse;
+        return vec3(0,0,0);
 
     // final diffuse term for daytime
-    vec3 diffuse =  diffuseCoeff * light.intensity * ndotl;
+    vec3 diffuse =  diffuseCoeff * intensity * ndotl;
 
     // reflected light direction = perfect reflection direction
     vec3 r = reflect(-l,n);
@@ -117,46 +219,125 @@ vec3 texphong(vec3 n, vec3 v, vec3 l, vec2 uv) {
     float rdotv = max( dot(r,v), 0.0);
 
     // specular contribution + gloss map
-    float shininess = tex.useGlossTexture? gloss : phong.shininess;
-    vec3 specular = phong.k_specular * light.intensity * pow(rdotv, shininess);
-
-    // return sum of all contributions
-    return ambient + diffuse + specular;
+    vec3 specular = phong.k_specular * intensity * pow(rdotv, shininess);
 
+    return diffuse + specular;
 }
 
-vec3 decodeNormal(vec3 normal) {
-    return normalize(normal * vec3(2, 2, 1) - vec3(1, 1, 0));
+#ifdef CLUSTERED_LIGHTS
+// index of the cluster containing this fragment
+int clusterIndex() {
+    ivec3 count = ivec3(clusterCount);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy / clusterParams.xy), ivec2(0), count.xy - 1);
+    float depth = max(-position_EC.z, 1e-6);
+    int slice = clamp(int(floor(log(depth / clusterParams.z) * clusterParams.w)), 0, count.z - 1);
+    return (slice * count.y + tile.y) * count.x + tile.x;
 }
+#endif
 
-void main() {
+/*
+ *  Calculate surface color based on Phong illumination model,
+ *  for the light of this pass or for all lights.
+ */
 
-    // default normal in tangent space is (0,0,1).
-    vec3 bumpValue = texture(bumpTexture, texcoord_frag).xyz;
+vec3 texphong(vec3 n, vec3 v, vec2 uv) {
+
+    // texture lookups, before any non-uniform branch (mip map selection)
+    vec3  diffuseCoeff = surfaceDiffuse(uv);
+    float shininess    = surfaceShininess(uv);
+
+    // ambient / emissive part, only added in first light pass
+    vec3 color = vec3(0,0,0);
+    if(lightPass <= 0)
+        color = surfaceAmbient(uv);
+
+#ifdef CLUSTERED_LIGHTS
+    // all lights reaching this fragment's cluster, including the frame's lights
+    uvec2 cluster = texelFetch(clusterGrid, clusterIndex()).xy;
+    for(uint k=0u; k<cluster.y; k++) {
+        int i = int(texelFetch(clusterLightIndices, int(cluster.x + k)).r);
+        vec4 position = texelFetch(clusterLights, 2*i);
+        vec3 intensity = texelFetch(clusterLights, 2*i+1).rgb;
+
+        vec3 toLight = position.xyz - position_WC;
+        intensity *= attenuation(toLight, position.w);
+#ifdef SHADOWS
+        // the frame's lights come first, see Scene::draw_scene_()
+        if(i < numLights)
+            intensity *= shadow(i);
+#endif
+
+        color += shadeLight(n, v, normalize(toLight * TBN_WC), intensity, diffuseCoeff, shininess);
+    }
+#else
+    // lights of this pass: one, or all of them
+    int first = max(lightPass, 0);
+    int last  = lightPass < 0? numLights : lightPass + 1;
+    for(int i=first; i<last; i++) {
+        vec3 toLight = lights[i].position_WC.xyz - position_WC;
+        vec3 intensity = lights[i].intensity.rgb * attenuation(toLight, lights[i].intensity.w);
+#ifdef SHADOWS
+        intensity *= shadow(i);
+#endif
+        color += shadeLight(n, v, normalize(toLight * TBN_WC), intensity, diffuseCoeff, shininess);
+    }
+#endif
 
-    // get bump direction (in tangent space) from bump texture
-    vec3 N = bump.use? decodeNormal(bumpValue) : vec3(0,0,1);
-    vec3 V = normalize(viewDir_TS);
-    vec3 L = normalize(lightDir_TS);
+    // return sum of all contributions
+    return color;
 
-    // calculate color using phong illumination
-    vec3 final_color = texphong(N, V, L, texcoord_frag);
+}
 
-    // calculate reflection of environment
+// reflection and refraction of the environment
+vec3 environmentColor() {
+#ifdef ENVIRONMENT_TEXTURE
     vec3 normalEC = normalize(normal_EC);
     vec3 viewdirEC = normalize(-position_EC.xyz);
     vec3 reflEC = reflect(-viewdirEC, normalEC); // note: not from bump map!
-    vec3 reflWC = (inverse(viewMatrix) * vec4(reflEC,0.0)).xyz;
+    vec3 reflWC = (inverseViewMatrix * vec4(reflEC,0.0)).xyz;
     vec3 c_mirror = envmap.k_mirror * texture(environmentTexture, reflWC).rgb;
 
     vec3 refrEC = refract(-viewdirEC, normalEC, envmap.refract_ratio);
-    vec3 refrWC = (inverse(viewMatrix) * vec4(refrEC,0.0)).xyz;
+    vec3 refrWC = (inverseViewMatrix * vec4(refrEC,0.0)).xyz;
     vec3 c_refract = envmap.k_refract * texture(environmentTexture, refrWC).rgb;
 
-    if(tex.useEnvironmentTexture)
-       final_color += c_mirror + c_refract;
+    return c_mirror + c_refract;
+#else
+    return vec3(0,0,0);
+#endif
+}
+
+vec3 decodeNormal(vec3 normal) {
+    return normalize(normal * vec3(2, 2, 1) - vec3(1, 1, 0));
+}
+
+void main() {
+
+    loadMaterial();
+
+    // default normal in tangent space is (0,0,1).
+    // get bump direction (in tangent space) from bump texture
+#ifdef BUMP_MAPPING
+    vec3 N = decodeNormal(texture(bumpTexture, texcoord_frag).xyz);
+#else
+    vec3 N = vec3(0,0,1);
+#endif
+
+#ifdef GBUFFER_OUTPUT
+    // deferred: everything that does not depend on the lights, see deferred_light.frag
+    gAlbedo      = vec4(surfaceDiffuse(texcoord_frag),
+                        clamp(surfaceShininess(texcoord_frag), 0.0, 255.0) / 255.0);
+    gNormalDepth = vec4(normalize(TBN_WC * N), -position_EC.z);
+    gEmission    = vec4(surfaceAmbient(texcoord_frag) + environmentColor(),
+                        dot(phong.k_specular, vec3(1.0/3.0)));
+#else
+    vec3 V = normalize(viewDir_TS);
+
+    // calculate color using phong illumination, plus environment
+    vec3 final_color = texphong(N, V, texcoord_frag) + environmentColor();
 
     outColor = vec4(final_color, 1.0);
     // outColor = vec4(1,0,0, 1.0);
+#endif
 
 }
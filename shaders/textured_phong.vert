@@ -6,13 +6,29 @@
 
 #version 150
 
-// transformation matrices
-uniform mat4 modelViewProjectionMatrix;
-uniform mat4 projectionMatrix;
-uniform mat4 modelViewMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 modelMatrix;
-uniform mat3 normalMatrix;
+// per-draw data, a slice of the draw list's buffer (see DrawUniforms)
+layout(std140) uniform DrawData {
+    mat4 modelMatrix;
+    mat4 modelViewMatrix;
+    mat4 modelViewProjectionMatrix;
+    mat3 normalMatrix;
+};
+
+// per-frame data, shared by all programs (see FrameUniforms)
+struct FrameLight {
+    vec4 position_WC;
+    vec4 intensity;   // w: range, <= 0: unbounded
+};
+layout(std140) uniform FrameData {
+    mat4  viewMatrix;
+    mat4  inverseViewMatrix;
+    mat4  projectionMatrix;
+    mat4  viewProjectionMatrix;
+    vec3  ambientLightIntensity;
+    float time;
+    int   numLights;
+    FrameLight lights[8];
+};
 
 // in: position and normal vector in model coordinates (_MC)
 in vec3 position_MC;
@@ -21,21 +37,21 @@ in vec3 tangent_MC;
 in vec3 bitangent_MC;
 in vec2 texcoord;
 
-// point light
-struct PointLight {
-    vec3 intensity;
-    vec4 position_WC;
-    int  pass;
+// parameters of all materials (see MaterialTable)
+struct MaterialRecord {
+    vec4  k_ambient;
+    vec4  k_diffuse;
+    vec4  k_specular;    // w: shininess
+    vec4  k_mirror;      // w: refract_ratio
+    vec4  k_refract;     // w: emissive_scale
+    ivec4 textures;      // use diffuse, emissive, gloss, environment
+    ivec4 mapping;       // bump use, bump debug, displacement use
+    vec4  scales;        // bump scale, displacement scale
 };
-uniform PointLight light;
-
-struct DisplacementMaterial {
-    bool use;
-    float scale;
+layout(std140) uniform MaterialData {
+    MaterialRecord materials[64];
 };
-uniform DisplacementMaterial displacement;
-uniform sampler2D displacementTexture;
-
+uniform int materialIndex;
 
 // output - transformed to eye coordinates (EC)
 out vec4 position_EC;
@@ -43,11 +59,21 @@ out vec3 normal_EC;
 
 // output - transformed to tangent space (TS)
 out vec3 viewDir_TS;
-out vec3 lightDir_TS;
+
+// output - world coordinates (WC), light directions are calculated per fragment
+out vec3 position_WC;
+out mat3 TBN_WC;
 
 // tex coords - just copied
 out vec2 texcoord_frag;
 
+// bit-identical to the depth pre-pass (depth_prepass.vert), for GL_EQUAL
+invariant gl_Position;
+
+#ifdef DISPLACEMENT_MAPPING
+// compiled in for DISPLACEMENT_MAPPING only, see TexturedPhongMaterial
+uniform sampler2D displacementTexture;
+
 // displacement mapping
 vec4 displace(vec4 pos) {
 
@@ -58,21 +84,23 @@ vec4 displace(vec4 pos) {
     disp *= 1.0 / modelMatrix[0][0];
 
     // user-controlled scaling of the displacement effect
-    disp *= displacement.scale;
+    disp *= materials[materialIndex].scales.y;
 
     // apply displacement
     pos += vec4(normal_MC,0)*disp;
 
     return pos;
 }
+#endif
 
 
 void main(void) {
 
     // apply displacement mapping?
     vec4 pos = vec4(position_MC,1);
-    if(displacement.use)
-        pos = displace(pos);
+#ifdef DISPLACEMENT_MAPPING
+    pos = displace(pos);
+#endif
 
     // vertex/fragment position in clip coordinates
     gl_Position  = modelViewProjectionMatrix * pos;
@@ -87,22 +115,19 @@ void main(void) {
     texcoord_frag = texcoord;
 
     // calculate position and T N B in world coordinates
-    mat4 viewMatrixInverse = inverse(viewMatrix);
     vec4 wcPosition      = modelMatrix*vec4(position_MC,1.0);
-    vec4 wcEyePosition   = viewMatrixInverse*vec4(0,0,0,1); // only works for perspective projection
-    vec4 wcLightPosition = light.position_WC;
+    vec4 wcEyePosition   = inverseViewMatrix*vec4(0,0,0,1); // only works for perspective projection
     vec3 wcNormal        = (modelMatrix*vec4(normal_MC, 0)).xyz;
     vec3 wcTangent       = (modelMatrix*vec4(tangent_MC, 0)).xyz;
     vec3 wcBitangent     = (modelMatrix*vec4(bitangent_MC, 0)).xyz;
 
-    // light and view dir in WC
-    vec3 wcLightDir = wcLightPosition.xyz - wcPosition.xyz;
+    // view dir in WC
     vec3 wcViewDir = wcEyePosition.xyz - wcPosition.xyz; // only for perspective!
 
-    // now convert to TS
-    mat3 TBN = mat3(wcTangent, wcBitangent, wcNormal);
-    lightDir_TS = wcLightDir * TBN;
-    viewDir_TS  = wcViewDir * TBN;
+    // now convert to TS; light dirs are converted in the fragment shader
+    TBN_WC = mat3(wcTangent, wcBitangent, wcNormal);
+    viewDir_TS  = wcViewDir * TBN_WC;
+    position_WC = wcPosition.xyz;
 
 }
 
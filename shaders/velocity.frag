@@ -0,0 +1,18 @@
+/*
+ * fragment shader of the velocity pass (see VelocityMaterial)
+ *
+ */
+
+#version 150
+
+in vec4 position_CC;
+in vec4 previousPosition_CC;
+
+// output: motion since the last frame, in texture coordinates
+out vec4 outColor;
+
+void main(void) {
+    vec2 current = position_CC.xy / position_CC.w;
+    vec2 previous = previousPosition_CC.xy / previousPosition_CC.w;
+    outColor = vec4((current - previous) * 0.5, 0, 1);
+}
@@ -0,0 +1,23 @@
+/*
+ * vertex shader of the velocity pass (see VelocityMaterial)
+ *
+ */
+
+#version 150
+
+// transformation matrices of this frame and of the last one
+uniform mat4 modelViewProjectionMatrix;
+uniform mat4 previousModelViewProjectionMatrix;
+
+// in: position in model coordinates (_MC)
+in vec3 position_MC;
+
+// out: clip positions, interpolated for the fragment
+out vec4 position_CC;
+out vec4 previousPosition_CC;
+
+void main(void) {
+    position_CC = modelViewProjectionMatrix * vec4(position_MC,1);
+    previousPosition_CC = previousModelViewProjectionMatrix * vec4(position_MC,1);
+    gl_Position = position_CC;
+}
@@ -0,0 +1,35 @@
+/*
+ * Velocity Motion Blur: averages samples along the motion of each pixel
+ *
+ */
+
+#version 150
+
+// image to be blurred
+uniform sampler2D post_tex;
+// motion of each pixel during the last frame, in texture coordinates
+uniform sampler2D post_tex2;
+
+// length of the trail in frames
+uniform int frames;
+
+// texture coords
+in vec2 texcoord_frag;
+
+// output: color
+out vec4 outColor;
+
+const int SAMPLES = 12;
+
+void main(void)
+{
+    // trail behind the pixel, over the given number of frames
+    vec2 trail = texture(post_tex2, texcoord_frag).rg * float(frames);
+
+    vec3 color = vec3(0);
+    for(int i = 0; i < SAMPLES; i++) {
+        float t = float(i) / float(SAMPLES - 1);
+        color += texture(post_tex, texcoord_frag - trail * t).rgb;
+    }
+    outColor = vec4(color / float(SAMPLES), 1);
+}
@@ -1,5 +1,6 @@
 #include "skybox.h"
 #include "geometry/cube.h"
+#include "render/glstate.h"
 
 SkyBox::SkyBox(std::shared_ptr<SkyBoxMaterial> material,
                std::shared_ptr<Node> world,
@@ -21,8 +22,9 @@ void SkyBox::draw(const Camera &cam)
     centeredCamera.setShaderTransformationMatrices(*material_, QMatrix4x4());
 
     // disable depth writing (and testing, does not matter in this case)
-    glDisable(GL_CULL_FACE);
-    glDisable(GL_DEPTH_TEST);
+    auto& state = GLState::current();
+    state.disable(GL_CULL_FACE);
+    state.disable(GL_DEPTH_TEST);
 
     // draw using centered (non-translated) camera
     cube_->draw(0);